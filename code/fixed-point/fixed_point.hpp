@@ -91,22 +91,22 @@ class FixedPoint {
     FixedPoint &operator=(const Y);
 
     template <typename Y>
-    bool operator==(const Y &);
+    bool operator==(const Y &) const;
 
     template <typename Y>
-    bool operator!=(const Y &);
+    bool operator!=(const Y &) const;
 
     template <typename Y>
-    bool operator<(const Y &);
+    bool operator<(const Y &) const;
 
     template <typename Y>
-    bool operator>(const Y &);
+    bool operator>(const Y &) const;
 
     template <typename Y>
-    bool operator<=(const Y &);
+    bool operator<=(const Y &) const;
 
     template <typename Y>
-    bool operator>=(const Y &);
+    bool operator>=(const Y &) const;
 
     template <typename Y>
     FixedPoint &operator+=(const Y);
@@ -132,17 +132,17 @@ class FixedPoint {
     template <typename Y>
     FixedPoint operator/(const Y);
 
-    bool operator==(const FixedPoint &);
+    bool operator==(const FixedPoint &) const;
 
-    bool operator!=(const FixedPoint &);
+    bool operator!=(const FixedPoint &) const;
 
-    bool operator<(const FixedPoint &);
+    bool operator<(const FixedPoint &) const;
 
-    bool operator>(const FixedPoint &);
+    bool operator>(const FixedPoint &) const;
 
-    bool operator<=(const FixedPoint &);
+    bool operator<=(const FixedPoint &) const;
 
-    bool operator>=(const FixedPoint &);
+    bool operator>=(const FixedPoint &) const;
 
     FixedPoint &operator+=(const FixedPoint &);
 
@@ -164,22 +164,22 @@ class FixedPoint {
     FixedPoint &operator=(const FixedPoint<Y, Z>);
 
     template <typename Y, int8_t Z>
-    bool operator==(const FixedPoint<Y, Z> &);
+    bool operator==(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
-    bool operator!=(const FixedPoint<Y, Z> &);
+    bool operator!=(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
-    bool operator<(const FixedPoint<Y, Z> &);
+    bool operator<(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
-    bool operator>(const FixedPoint<Y, Z> &);
+    bool operator>(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
-    bool operator<=(const FixedPoint<Y, Z> &);
+    bool operator<=(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
-    bool operator>=(const FixedPoint<Y, Z> &);
+    bool operator>=(const FixedPoint<Y, Z> &) const;
 
     template <typename Y, int8_t Z>
     FixedPoint &operator+=(const FixedPoint<Y, Z> &);
@@ -211,6 +211,10 @@ class FixedPoint {
     /// \brief Get the raw, underlying value.
     const T getRaw() const;
 
+    /// \brief Creates a value directly from a raw, underlying value.
+    /// \param raw The underlying value, already scaled by the precision multiplier.
+    static FixedPoint fromRaw(T raw);
+
     /// \brief Returns the number of precision digits of the class.
     constexpr int8_t getPrecision() const;
 
@@ -247,37 +251,37 @@ FixedPoint<T, Precision> &FixedPoint<T, Precision>::operator=(const Y rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator==(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator==(const Y &rhs) const {
     return value == rhs * getPrecisionMultiplier();
 }
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator!=(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator!=(const Y &rhs) const {
     return value != rhs * getPrecisionMultiplier();
 }
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator<(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator<(const Y &rhs) const {
     return value < rhs * getPrecisionMultiplier();
 }
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator>(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator>(const Y &rhs) const {
     return value > rhs * getPrecisionMultiplier();
 }
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator<=(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator<=(const Y &rhs) const {
     return value <= rhs * getPrecisionMultiplier();
 }
 
 template <typename T, int8_t Precision>
 template <typename Y>
-bool FixedPoint<T, Precision>::operator>=(const Y &rhs) {
+bool FixedPoint<T, Precision>::operator>=(const Y &rhs) const {
     return value >= rhs * getPrecisionMultiplier();
 }
 
@@ -339,32 +343,32 @@ FixedPoint<T, Precision> FixedPoint<T, Precision>::operator/(const Y rhs) {
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator==(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator==(const FixedPoint &rhs) const {
     return value == rhs.value;
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator!=(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator!=(const FixedPoint &rhs) const {
     return value != rhs.value;
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator<(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator<(const FixedPoint &rhs) const {
     return value < rhs.value;
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator>(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator>(const FixedPoint &rhs) const {
     return value > rhs.value;
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator<=(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator<=(const FixedPoint &rhs) const {
     return value <= rhs.value;
 }
 
 template <typename T, int8_t Precision>
-bool FixedPoint<T, Precision>::operator>=(const FixedPoint &rhs) {
+bool FixedPoint<T, Precision>::operator>=(const FixedPoint &rhs) const {
     return value >= rhs.value;
 }
 
@@ -428,7 +432,7 @@ FixedPoint<T, Precision> &FixedPoint<T, Precision>::operator=(FixedPoint<Y, Z> r
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator==(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator==(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value == static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -440,7 +444,7 @@ bool FixedPoint<T, Precision>::operator==(const FixedPoint<Y, Z> &rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator!=(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator!=(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value != static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -452,7 +456,7 @@ bool FixedPoint<T, Precision>::operator!=(const FixedPoint<Y, Z> &rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator<(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator<(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value < static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -464,7 +468,7 @@ bool FixedPoint<T, Precision>::operator<(const FixedPoint<Y, Z> &rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator>(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator>(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value > static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -476,7 +480,7 @@ bool FixedPoint<T, Precision>::operator>(const FixedPoint<Y, Z> &rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator<=(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator<=(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value <= static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -488,7 +492,7 @@ bool FixedPoint<T, Precision>::operator<=(const FixedPoint<Y, Z> &rhs) {
 
 template <typename T, int8_t Precision>
 template <typename Y, int8_t Z>
-bool FixedPoint<T, Precision>::operator>=(const FixedPoint<Y, Z> &rhs) {
+bool FixedPoint<T, Precision>::operator>=(const FixedPoint<Y, Z> &rhs) const {
     if constexpr (Precision > Z) {
         return value >= static_cast<T>(rhs.getRaw() * std::pow(static_cast<T>(10), Precision - Z));
     } else if constexpr (Precision < Z) {
@@ -591,6 +595,13 @@ const T FixedPoint<T, Precision>::getRaw() const {
     return value;
 }
 
+template <typename T, int8_t Precision>
+FixedPoint<T, Precision> FixedPoint<T, Precision>::fromRaw(T raw) {
+    FixedPoint retVal;
+    retVal.value = raw;
+    return retVal;
+}
+
 template <typename T, int8_t Precision>
 constexpr int8_t FixedPoint<T, Precision>::getPrecision() const {
     return Precision;
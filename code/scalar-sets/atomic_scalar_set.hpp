@@ -0,0 +1,358 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_ATOMIC_SCALAR_SET_HPP
+#define STEC_ATOMIC_SCALAR_SET_HPP
+
+#include "scalar_set.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace stec {
+
+/// The assumed size of a cache line, used to keep values that are written by
+/// different threads from sharing one.
+constexpr std::size_t cCacheLineSize = 64;
+
+namespace detail {
+
+/// \brief Atomically adds to the value, falling back to a compare-exchange
+/// loop for floating-point types, which lack a native fetch_add before C++20.
+template <typename T>
+T atomicFetchAdd(std::atomic<T> &value, T rhs,
+                 std::memory_order order) noexcept {
+  if constexpr (std::is_integral<T>::value) {
+    return value.fetch_add(rhs, order);
+  } else {
+    T expected = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(expected, expected + rhs, order,
+                                        std::memory_order_relaxed)) {
+    }
+    return expected;
+  }
+}
+
+} // namespace detail
+
+/// \brief A lock-free counterpart of the EnumeratedScalarSet, for values that
+/// are modified from many threads at once, such as telemetry counters.
+/// \tparam T The underlying type of the template (ex int, float, etc.)
+/// \tparam EnumClass The enum type to use, must be zero-based and be in a solid
+/// incremental block.
+/// \tparam NumValues The number of values held in the template
+///
+/// Each value is kept on its own cache line, so threads bumping different
+/// values never contend with each other. Reading the whole set back with
+/// snapshot() reads each value atomically, but not all of them at the same
+/// instant.
+template <typename T, class EnumClass, int NumValues>
+class AtomicEnumeratedScalarSet {
+  static_assert(std::is_arithmetic<T>::value,
+                "AtomicEnumeratedScalarSet - Template parameter T must be of "
+                "arithmetic type.");
+  static_assert(std::atomic<T>::is_always_lock_free,
+                "AtomicEnumeratedScalarSet - Template parameter T must be "
+                "lock-free when atomic.");
+
+public:
+  /// \brief Initial value constructor
+  /// \param initial This is the value the template vars are set to.
+  AtomicEnumeratedScalarSet(T initial = 0) noexcept;
+
+  /// \brief Initial set constructor
+  /// \param initial The set of values to start with.
+  AtomicEnumeratedScalarSet(
+      const EnumeratedScalarSet<T, EnumClass, NumValues> &initial) noexcept;
+
+  AtomicEnumeratedScalarSet(const AtomicEnumeratedScalarSet &) = delete;
+  AtomicEnumeratedScalarSet &
+  operator=(const AtomicEnumeratedScalarSet &) = delete;
+
+  /// \brief Atomically adds to the value, denoted by the index.
+  /// \return The value held immediately before the addition.
+  T fetch_add(const EnumClass, const T,
+              std::memory_order = std::memory_order_relaxed) noexcept;
+
+  /// \brief Atomically subtracts from the value, denoted by the index.
+  /// \return The value held immediately before the subtraction.
+  T fetch_sub(const EnumClass, const T,
+              std::memory_order = std::memory_order_relaxed) noexcept;
+
+  /// \brief Atomically adds each of the elements of the given set.
+  template <typename Y, class YArithmetic>
+  void add(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &,
+           std::memory_order = std::memory_order_relaxed) noexcept;
+
+  /// \brief Atomically reads the value, denoted by the index.
+  T load(const EnumClass, std::memory_order = std::memory_order_relaxed) const
+      noexcept;
+
+  /// \brief Atomically replaces the value, denoted by the index.
+  void store(const EnumClass, const T,
+             std::memory_order = std::memory_order_relaxed) noexcept;
+
+  /// \brief Returns a plain copy of all of the current values.
+  EnumeratedScalarSet<T, EnumClass, NumValues> snapshot() const noexcept;
+
+  /// \brief Replaces all of the values with the given one, returning what each
+  /// value held beforehand. Nothing added concurrently is lost.
+  EnumeratedScalarSet<T, EnumClass, NumValues> exchange(T value = 0) noexcept;
+
+private:
+  /// A single value, padded out to fill an entire cache line.
+  struct alignas(cCacheLineSize) Cell {
+    std::atomic<T> value;
+  };
+
+  /// The actual array of stored stat values.
+  std::array<Cell, NumValues> cells;
+};
+
+/// \brief A set of values that many threads add to, kept as a number of
+/// shards that are merged back together on request.
+/// \tparam T The underlying type of the template (ex int, float, etc.)
+/// \tparam EnumClass The enum type to use, must be zero-based and be in a solid
+/// incremental block.
+/// \tparam NumValues The number of values held in the template
+/// \tparam NumShards The number of separate copies of the set that are kept.
+///
+/// Each thread is assigned a shard the first time it adds anything, and from
+/// then on only adds into that shard. As long as there are no more threads
+/// than shards, no cache line is ever written by more than one thread, and the
+/// adds never contend. Past that, threads begin sharing shards, which is still
+/// correct, just slower.
+///
+/// Compared to the AtomicEnumeratedScalarSet, adding is cheaper and a whole
+/// set can be added at once, at the expense of snapshot() having to sum up
+/// every shard.
+template <typename T, class EnumClass, int NumValues, int NumShards = 64>
+class ShardedEnumeratedScalarSet {
+  static_assert(std::is_arithmetic<T>::value,
+                "ShardedEnumeratedScalarSet - Template parameter T must be of "
+                "arithmetic type.");
+  static_assert(std::atomic<T>::is_always_lock_free,
+                "ShardedEnumeratedScalarSet - Template parameter T must be "
+                "lock-free when atomic.");
+  static_assert(NumShards > 0, "ShardedEnumeratedScalarSet - Template "
+                               "parameter NumShards must be positive.");
+
+public:
+  /// \brief Default constructor, sets all values to 0.
+  ShardedEnumeratedScalarSet() noexcept;
+
+  ShardedEnumeratedScalarSet(const ShardedEnumeratedScalarSet &) = delete;
+  ShardedEnumeratedScalarSet &
+  operator=(const ShardedEnumeratedScalarSet &) = delete;
+
+  /// \brief Adds to the value, denoted by the index, in this thread's shard.
+  void add(const EnumClass, const T) noexcept;
+
+  /// \brief Adds each of the elements of the given set to this thread's shard.
+  template <typename Y, class YArithmetic>
+  void add(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &)
+      noexcept;
+
+  /// \brief Returns the sum of all of the shards.
+  EnumeratedScalarSet<T, EnumClass, NumValues> snapshot() const noexcept;
+
+  /// \brief Sets all of the shards back to 0, returning what their sum was.
+  /// Nothing added concurrently is lost.
+  EnumeratedScalarSet<T, EnumClass, NumValues> exchange() noexcept;
+
+private:
+  /// A full set of values, padded out so that no two shards share a cache
+  /// line.
+  struct alignas(cCacheLineSize) Shard {
+    std::array<std::atomic<T>, NumValues> values;
+  };
+
+  /// \brief Returns the shard that belongs to the calling thread.
+  Shard &localShard() noexcept;
+
+  /// The per-thread copies of the set.
+  std::array<Shard, NumShards> shards;
+};
+
+template <typename T, class EnumClass, int NumValues>
+AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::AtomicEnumeratedScalarSet(
+    T initial) noexcept {
+  for (auto &cell : cells) {
+    cell.value.store(initial, std::memory_order_relaxed);
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::AtomicEnumeratedScalarSet(
+    const EnumeratedScalarSet<T, EnumClass, NumValues> &initial) noexcept {
+  for (int i = 0; i < NumValues; i++) {
+    cells[i].value.store(initial[static_cast<EnumClass>(i)],
+                         std::memory_order_relaxed);
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+T AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::fetch_add(
+    const EnumClass index, const T rhs, std::memory_order order) noexcept {
+  return detail::atomicFetchAdd(
+      cells[static_cast<typename std::underlying_type<EnumClass>::type>(index)]
+          .value,
+      rhs, order);
+}
+
+template <typename T, class EnumClass, int NumValues>
+T AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::fetch_sub(
+    const EnumClass index, const T rhs, std::memory_order order) noexcept {
+  return detail::atomicFetchAdd(
+      cells[static_cast<typename std::underlying_type<EnumClass>::type>(index)]
+          .value,
+      static_cast<T>(-rhs), order);
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y, class YArithmetic>
+void AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::add(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &rhs,
+    std::memory_order order) noexcept {
+  for (int i = 0; i < NumValues; i++) {
+    T value = static_cast<T>(rhs[static_cast<EnumClass>(i)]);
+    if (value != 0) {
+      detail::atomicFetchAdd(cells[i].value, value, order);
+    }
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+T AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::load(
+    const EnumClass index, std::memory_order order) const noexcept {
+  return cells[static_cast<typename std::underlying_type<EnumClass>::type>(
+                   index)]
+      .value.load(order);
+}
+
+template <typename T, class EnumClass, int NumValues>
+void AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::store(
+    const EnumClass index, const T value, std::memory_order order) noexcept {
+  cells[static_cast<typename std::underlying_type<EnumClass>::type>(index)]
+      .value.store(value, order);
+}
+
+template <typename T, class EnumClass, int NumValues>
+EnumeratedScalarSet<T, EnumClass, NumValues>
+AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::snapshot() const noexcept {
+  EnumeratedScalarSet<T, EnumClass, NumValues> retVal;
+  for (int i = 0; i < NumValues; i++) {
+    retVal[static_cast<EnumClass>(i)] =
+        cells[i].value.load(std::memory_order_relaxed);
+  }
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues>
+EnumeratedScalarSet<T, EnumClass, NumValues>
+AtomicEnumeratedScalarSet<T, EnumClass, NumValues>::exchange(T value) noexcept {
+  EnumeratedScalarSet<T, EnumClass, NumValues> retVal;
+  for (int i = 0; i < NumValues; i++) {
+    retVal[static_cast<EnumClass>(i)] =
+        cells[i].value.exchange(value, std::memory_order_relaxed);
+  }
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+ShardedEnumeratedScalarSet<T, EnumClass, NumValues,
+                           NumShards>::ShardedEnumeratedScalarSet() noexcept {
+  for (auto &shard : shards) {
+    for (auto &value : shard.values) {
+      value.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+void ShardedEnumeratedScalarSet<T, EnumClass, NumValues, NumShards>::add(
+    const EnumClass index, const T rhs) noexcept {
+  detail::atomicFetchAdd(
+      localShard().values[static_cast<
+          typename std::underlying_type<EnumClass>::type>(index)],
+      rhs, std::memory_order_relaxed);
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+template <typename Y, class YArithmetic>
+void ShardedEnumeratedScalarSet<T, EnumClass, NumValues, NumShards>::add(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  Shard &shard = localShard();
+  for (int i = 0; i < NumValues; i++) {
+    T value = static_cast<T>(rhs[static_cast<EnumClass>(i)]);
+    if (value != 0) {
+      detail::atomicFetchAdd(shard.values[i], value,
+                             std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+EnumeratedScalarSet<T, EnumClass, NumValues>
+ShardedEnumeratedScalarSet<T, EnumClass, NumValues, NumShards>::snapshot() const
+    noexcept {
+  EnumeratedScalarSet<T, EnumClass, NumValues> retVal;
+  for (auto const &shard : shards) {
+    for (int i = 0; i < NumValues; i++) {
+      retVal[static_cast<EnumClass>(i)] +=
+          shard.values[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+EnumeratedScalarSet<T, EnumClass, NumValues>
+ShardedEnumeratedScalarSet<T, EnumClass, NumValues,
+                           NumShards>::exchange() noexcept {
+  EnumeratedScalarSet<T, EnumClass, NumValues> retVal;
+  for (auto &shard : shards) {
+    for (int i = 0; i < NumValues; i++) {
+      retVal[static_cast<EnumClass>(i)] +=
+          shard.values[i].exchange(0, std::memory_order_relaxed);
+    }
+  }
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues, int NumShards>
+typename ShardedEnumeratedScalarSet<T, EnumClass, NumValues, NumShards>::Shard &
+ShardedEnumeratedScalarSet<T, EnumClass, NumValues,
+                           NumShards>::localShard() noexcept {
+  // Threads are handed out shards round-robin as they first show up, which
+  // spreads them out evenly regardless of how their IDs happen to hash.
+  static std::atomic<unsigned> nextShard{0};
+  thread_local unsigned const threadShard =
+      nextShard.fetch_add(1, std::memory_order_relaxed);
+
+  return shards[threadShard % NumShards];
+}
+
+} // namespace stec
+
+#endif // STEC_ATOMIC_SCALAR_SET_HPP
@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "atomic_scalar_set.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class Counter {
+  Kills,
+  Deaths,
+  Assists,
+  Damage,
+};
+
+using Set = stec::EnumeratedScalarSet<std::int64_t, Counter>;
+
+/// The number of updates made by each thread.
+constexpr int cUpdatesPerThread = 200000;
+
+/// \brief A plain set behind a mutex, as the baseline to compare against.
+struct LockedSet {
+  void add(Counter counter, std::int64_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    set[counter] += value;
+  }
+
+  Set snapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return set;
+  }
+
+  std::mutex mutex;
+  Set set;
+};
+
+/// \brief Runs the update on the given number of threads at once, each
+/// updating every counter in turn.
+/// \return The average time per update, in nanoseconds.
+template <typename Update>
+double run(int numThreads, Update &&update) {
+  std::atomic<bool> start{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++) {
+    threads.emplace_back([&] {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (int j = 0; j < cUpdatesPerThread; j++) {
+        update(static_cast<Counter>(j % Set::size()));
+      }
+    });
+  }
+
+  auto const begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double, std::nano> const elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+  return elapsed.count() / (static_cast<double>(numThreads) *
+                            cUpdatesPerThread);
+}
+
+/// \brief Returns whether the counters add up to every update being made.
+bool isComplete(const Set &set, int numThreads) {
+  std::int64_t total = 0;
+  for (int i = 0; i < Set::size(); i++) {
+    total += set[static_cast<Counter>(i)];
+  }
+  return total == static_cast<std::int64_t>(numThreads) * cUpdatesPerThread;
+}
+
+int main() {
+  std::cout << "Nanoseconds per update, with every thread updating the same "
+               "set\n\n"
+            << std::setw(8) << "Threads" << std::setw(10) << "Locked"
+            << std::setw(10) << "Atomic" << std::setw(10) << "Sharded"
+            << '\n';
+
+  bool complete = true;
+  for (int numThreads = 1; numThreads <= 64; numThreads *= 2) {
+    LockedSet locked;
+    double const lockedTime = run(numThreads, [&](Counter counter) {
+      locked.add(counter, 1);
+    });
+    complete &= isComplete(locked.snapshot(), numThreads);
+
+    stec::AtomicEnumeratedScalarSet<std::int64_t, Counter, Set::size()> atomic;
+    double const atomicTime = run(numThreads, [&](Counter counter) {
+      atomic.fetch_add(counter, 1);
+    });
+    complete &= isComplete(atomic.snapshot(), numThreads);
+
+    stec::ShardedEnumeratedScalarSet<std::int64_t, Counter, Set::size()>
+        sharded;
+    double const shardedTime = run(numThreads, [&](Counter counter) {
+      sharded.add(counter, 1);
+    });
+    complete &= isComplete(sharded.snapshot(), numThreads);
+
+    std::cout << std::fixed << std::setprecision(2) << std::setw(8)
+              << numThreads << std::setw(10) << lockedTime << std::setw(10)
+              << atomicTime << std::setw(10) << shardedTime << '\n';
+  }
+
+  if (!complete) {
+    std::cout << "\nSome updates were lost.\n";
+    return 1;
+  }
+  return 0;
+}
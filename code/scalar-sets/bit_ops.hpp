@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_BIT_OPS_HPP
+#define STEC_BIT_OPS_HPP
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace stec {
+
+namespace detail {
+
+/// \brief Returns the index of the lowest set bit of the value, which must not
+/// be zero. Compiles down to a single tzcnt/bsf where available.
+inline int countTrailingZeros(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long retVal;
+  _BitScanForward64(&retVal, value);
+  return static_cast<int>(retVal);
+#else
+  int retVal = 0;
+  while ((value & 1) == 0) {
+    value >>= 1;
+    retVal++;
+  }
+  return retVal;
+#endif
+}
+
+/// \brief Returns the index of the highest set bit of the value, which must
+/// not be zero. Compiles down to a single lzcnt/bsr where available.
+inline int highestSetBit(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long retVal;
+  _BitScanReverse64(&retVal, value);
+  return static_cast<int>(retVal);
+#else
+  int retVal = 0;
+  while (value >>= 1) {
+    retVal++;
+  }
+  return retVal;
+#endif
+}
+
+/// \brief Returns the number of set bits in the value. Compiles down to a
+/// single popcnt where available.
+inline int popCount(std::uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  return static_cast<int>(__popcnt64(value));
+#else
+  int retVal = 0;
+  for (; value != 0; value &= value - 1) {
+    retVal++;
+  }
+  return retVal;
+#endif
+}
+
+/// \brief Calls the function with the index of each set bit in the array of
+/// 64-bit words, in ascending order.
+template <typename Function>
+void forEachSetBit(const std::uint64_t *words, int numWords,
+                   Function &&function) {
+  for (int word = 0; word < numWords; word++) {
+    std::uint64_t bits = words[word];
+    while (bits != 0) {
+      function(word * 64 + countTrailingZeros(bits));
+      // Clear the lowest set bit.
+      bits &= bits - 1;
+    }
+  }
+}
+
+} // namespace detail
+
+} // namespace stec
+
+#endif // STEC_BIT_OPS_HPP
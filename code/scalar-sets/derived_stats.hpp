@@ -0,0 +1,302 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_DERIVED_STATS_HPP
+#define STEC_DERIVED_STATS_HPP
+
+#include "bit_ops.hpp"
+#include "parallel_for.hpp"
+#include "scalar_set_delta.hpp"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace stec {
+
+/// The outcome of declaring a derived field.
+enum class DerivedStatus {
+  /// The field has been declared.
+  Ok,
+  /// The field is already derived from other fields.
+  AlreadyDerived,
+  /// The field would end up depending on itself, directly or through other
+  /// derived fields.
+  Cycle,
+};
+
+/// \brief Works out fields of EnumeratedScalarSets that are derived from other
+/// fields, such as carry weight from strength.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet.
+///
+/// Each derived field is declared with the fields it's worked out from, which
+/// may themselves be derived, and a function that works it out from the set.
+/// Declarations that would make a field depend on itself are rejected, so the
+/// fields always form a graph without cycles. The order to work out the
+/// derived fields in, and which derived fields each field affects, are worked
+/// out once as each field is declared, rather than on every evaluation.
+///
+/// Given which fields have changed, such as from changedValues(), only the
+/// derived fields affected by them are worked out again. Populations of sets
+/// are split across threads in contiguous chunks.
+template <typename ScalarSet>
+class DerivedStats {
+public:
+  using value_type = typename ScalarSet::value_type;
+  using enum_type = typename ScalarSet::enum_type;
+
+  /// The function working out a derived field from the rest of the set.
+  using Function = std::function<value_type(const ScalarSet &)>;
+
+  /// \brief Declares a derived field.
+  /// \param field The field being derived.
+  /// \param inputs The fields the function reads.
+  /// \param function The function working out the field's value, which may
+  /// only read the given inputs of the set.
+  /// \return Ok if the field was declared, otherwise why it wasn't.
+  DerivedStatus derive(enum_type field, std::initializer_list<enum_type> inputs,
+                       Function function);
+
+  /// \brief Returns whether the field is derived.
+  bool isDerived(enum_type field) const noexcept {
+    return static_cast<bool>(functions[toIndex(field)]);
+  }
+
+  /// \brief Returns the derived fields in the order they're worked out in,
+  /// with every field coming after the derived fields it's worked out from.
+  const std::vector<int> &order() const noexcept { return evaluationOrder; }
+
+  /// \brief Works out every derived field of the set.
+  void evaluate(ScalarSet &set) const;
+
+  /// \brief Works out the derived fields affected by the changed fields.
+  /// \param set The set to update.
+  /// \param changed The fields that have changed since the derived fields
+  /// were last worked out.
+  void evaluate(ScalarSet &set,
+                const ChangeMask<ScalarSet::size()> &changed) const;
+
+  /// \brief Works out every derived field of each of the sets.
+  /// \param sets The first of the sets.
+  /// \param count The number of sets.
+  /// \param numThreads The most threads to split the work across, or 0 for one
+  /// per hardware thread.
+  void evaluate(ScalarSet *sets, std::size_t count,
+                unsigned numThreads = 0) const;
+
+  /// \brief Works out the derived fields affected by the changed fields, for
+  /// each of the sets.
+  /// \param sets The first of the sets.
+  /// \param count The number of sets.
+  /// \param changed The fields that have changed in all of the sets since
+  /// the derived fields were last worked out.
+  /// \param numThreads The most threads to split the work across, or 0 for one
+  /// per hardware thread.
+  void evaluate(ScalarSet *sets, std::size_t count,
+                const ChangeMask<ScalarSet::size()> &changed,
+                unsigned numThreads = 0) const;
+
+private:
+  using Mask = ChangeMask<ScalarSet::size()>;
+
+  static int toIndex(enum_type field) noexcept {
+    return static_cast<int>(field);
+  }
+
+  static bool test(const Mask &mask, int field) noexcept {
+    return (mask[field / 64] >> (field % 64) & 1) != 0;
+  }
+
+  static void setBit(Mask &mask, int field) noexcept {
+    mask[field / 64] |= static_cast<std::uint64_t>(1) << (field % 64);
+  }
+
+  static void merge(Mask &into, const Mask &from) noexcept {
+    for (std::size_t word = 0; word < into.size(); word++) {
+      into[word] |= from[word];
+    }
+  }
+
+  /// \brief Works out the order of the derived fields, and what each field
+  /// affects.
+  void sort();
+
+  /// \brief Works out the derived fields of the set that are in the mask.
+  void evaluate(ScalarSet &set, const Mask *affected) const;
+
+  /// \brief Returns the derived fields affected by the changed fields.
+  Mask affectedBy(const Mask &changed) const noexcept;
+
+  std::array<Function, ScalarSet::size()> functions;
+  /// The fields each field is worked out from.
+  std::array<Mask, ScalarSet::size()> inputMasks{};
+  /// The derived fields that each field affects, directly or through other
+  /// derived fields.
+  std::array<Mask, ScalarSet::size()> downstream{};
+  std::vector<int> evaluationOrder;
+};
+
+template <typename ScalarSet>
+DerivedStatus
+DerivedStats<ScalarSet>::derive(enum_type field,
+                                std::initializer_list<enum_type> inputs,
+                                Function function) {
+  int const index = toIndex(field);
+  if (isDerived(field)) {
+    return DerivedStatus::AlreadyDerived;
+  }
+
+  Mask inputMask{};
+  for (enum_type const input : inputs) {
+    int const inputIndex = toIndex(input);
+    // Any input that already depends on the field would close a loop.
+    if (inputIndex == index || test(downstream[index], inputIndex)) {
+      return DerivedStatus::Cycle;
+    }
+    setBit(inputMask, inputIndex);
+  }
+
+  functions[index] = std::move(function);
+  inputMasks[index] = inputMask;
+  sort();
+
+  return DerivedStatus::Ok;
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::evaluate(ScalarSet &set) const {
+  evaluate(set, nullptr);
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::evaluate(ScalarSet &set,
+                                       const Mask &changed) const {
+  Mask const affected = affectedBy(changed);
+  evaluate(set, &affected);
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::evaluate(ScalarSet *sets, std::size_t count,
+                                       unsigned numThreads) const {
+  numThreads = detail::threadCount(count, numThreads);
+  detail::parallelFor(count, numThreads,
+                      [&](unsigned, std::size_t begin, std::size_t end) {
+                        for (std::size_t i = begin; i < end; i++) {
+                          evaluate(sets[i], nullptr);
+                        }
+                      });
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::evaluate(ScalarSet *sets, std::size_t count,
+                                       const Mask &changed,
+                                       unsigned numThreads) const {
+  Mask const affected = affectedBy(changed);
+  numThreads = detail::threadCount(count, numThreads);
+  detail::parallelFor(count, numThreads,
+                      [&](unsigned, std::size_t begin, std::size_t end) {
+                        for (std::size_t i = begin; i < end; i++) {
+                          evaluate(sets[i], &affected);
+                        }
+                      });
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::sort() {
+  constexpr int cNumFields = ScalarSet::size();
+
+  // Kahn's algorithm, counting for each derived field how many of its inputs
+  // are derived fields not yet placed.
+  std::array<int, cNumFields> waitingOn{};
+  std::vector<int> ready;
+  for (int field = 0; field < cNumFields; field++) {
+    if (!functions[field]) {
+      continue;
+    }
+    detail::forEachSetBit(inputMasks[field].data(),
+                          static_cast<int>(inputMasks[field].size()),
+                          [&](int input) {
+                            if (functions[input]) {
+                              waitingOn[field]++;
+                            }
+                          });
+    if (waitingOn[field] == 0) {
+      ready.push_back(field);
+    }
+  }
+
+  evaluationOrder.clear();
+  while (!ready.empty()) {
+    int const field = ready.back();
+    ready.pop_back();
+    evaluationOrder.push_back(field);
+    for (int other = 0; other < cNumFields; other++) {
+      if (functions[other] && test(inputMasks[other], field) &&
+          --waitingOn[other] == 0) {
+        ready.push_back(other);
+      }
+    }
+  }
+
+  // With the inputs of each field placed before it, what affects each field
+  // is its inputs, plus whatever affects those.
+  std::array<Mask, cNumFields> upstream{};
+  for (int const field : evaluationOrder) {
+    upstream[field] = inputMasks[field];
+    detail::forEachSetBit(inputMasks[field].data(),
+                          static_cast<int>(inputMasks[field].size()),
+                          [&](int input) {
+                            merge(upstream[field], upstream[input]);
+                          });
+  }
+
+  downstream = {};
+  for (int const field : evaluationOrder) {
+    detail::forEachSetBit(upstream[field].data(),
+                          static_cast<int>(upstream[field].size()),
+                          [&](int input) { setBit(downstream[input], field); });
+  }
+}
+
+template <typename ScalarSet>
+void DerivedStats<ScalarSet>::evaluate(ScalarSet &set,
+                                       const Mask *affected) const {
+  for (int const field : evaluationOrder) {
+    if (affected == nullptr || test(*affected, field)) {
+      set.data()[field] = functions[field](set);
+    }
+  }
+}
+
+template <typename ScalarSet>
+typename DerivedStats<ScalarSet>::Mask
+DerivedStats<ScalarSet>::affectedBy(const Mask &changed) const noexcept {
+  Mask retVal{};
+  detail::forEachSetBit(changed.data(), static_cast<int>(changed.size()),
+                        [&](int field) {
+                          if (field < ScalarSet::size()) {
+                            merge(retVal, downstream[field]);
+                          }
+                        });
+  return retVal;
+}
+
+} // namespace stec
+
+#endif // STEC_DERIVED_STATS_HPP
@@ -0,0 +1,174 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_ENUM_TRAITS_HPP
+#define STEC_ENUM_TRAITS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/// The highest number of enum values that will be searched for when counting
+/// the values of an enum automatically. Raising it slows down compilation.
+#ifndef STEC_ENUM_TRAITS_MAX_VALUES
+#define STEC_ENUM_TRAITS_MAX_VALUES 512
+#endif
+
+namespace stec {
+
+namespace detail {
+
+/// \brief Returns the compiler's description of this function, which includes
+/// the spelling of the given enum value as a template argument.
+template <typename EnumClass, EnumClass Value>
+constexpr std::string_view enumSignature() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+  return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+  return __FUNCSIG__;
+#else
+  return {};
+#endif
+}
+
+/// \brief Returns the name of the given enum value, without any scope, or an
+/// empty string if the value has no name.
+///
+/// Values without names are spelt by the compilers as a cast, such as
+/// '(Special)7', which is how they are told apart.
+template <typename EnumClass, EnumClass Value>
+constexpr std::string_view enumValueName() noexcept {
+  constexpr std::string_view signature = enumSignature<EnumClass, Value>();
+
+#if defined(__clang__) || defined(__GNUC__)
+  // GCC: '[with EnumClass = Special; EnumClass Value = Special::Luck; ...]'
+  // Clang: '[EnumClass = Special, Value = Special::Luck]'
+  constexpr std::size_t start = signature.find(" Value = ") + 9;
+  constexpr std::size_t end = signature.find_first_of(";]", start);
+#elif defined(_MSC_VER)
+  // MSVC: '... enumSignature<enum Special,Special::Luck>(void)'
+  constexpr std::size_t end = signature.rfind(">(void)");
+  constexpr std::size_t start = signature.rfind(',', end) + 1;
+#else
+  constexpr std::size_t start = 0;
+  constexpr std::size_t end = 0;
+#endif
+  constexpr std::string_view value = signature.substr(start, end - start);
+
+  if (value.empty() || value.front() == '(' ||
+      (value.front() >= '0' && value.front() <= '9') || value.front() == '-') {
+    return {};
+  }
+  return value.substr(value.rfind(':') + 1);
+}
+
+/// \brief Counts the number of values in the enum, by finding the first value
+/// from zero upwards that has no name.
+template <typename EnumClass, std::size_t... Indices>
+constexpr int enumCount(std::index_sequence<Indices...>) noexcept {
+  constexpr bool named[] = {
+      !enumValueName<EnumClass, static_cast<EnumClass>(Indices)>().empty()...};
+
+  for (std::size_t i = 0; i < sizeof...(Indices); i++) {
+    if (!named[i]) {
+      return static_cast<int>(i);
+    }
+  }
+  return static_cast<int>(sizeof...(Indices));
+}
+
+/// \brief Returns the number of values to search through for the given enum.
+template <typename EnumClass>
+constexpr std::size_t enumSearchRange() noexcept {
+  using Underlying = typename std::underlying_type<EnumClass>::type;
+  return static_cast<std::size_t>(std::numeric_limits<Underlying>::max()) <
+                 STEC_ENUM_TRAITS_MAX_VALUES
+             ? static_cast<std::size_t>(
+                   std::numeric_limits<Underlying>::max()) +
+                   1
+             : STEC_ENUM_TRAITS_MAX_VALUES;
+}
+
+template <typename EnumClass, std::size_t... Indices>
+constexpr std::array<std::string_view, sizeof...(Indices)>
+enumNames(std::index_sequence<Indices...>) noexcept {
+  return {{enumValueName<EnumClass, static_cast<EnumClass>(Indices)>()...}};
+}
+
+} // namespace detail
+
+/// \brief Compile-time information about an enum class used to index an
+/// EnumeratedScalarSet.
+/// \tparam EnumClass The enum type to use, must be zero-based and be in a solid
+/// incremental block.
+///
+/// By default, the number of values and their names are worked out by the
+/// compiler, by searching up from zero for the first value that has no name.
+/// This works with GCC, Clang and MSVC, for up to STEC_ENUM_TRAITS_MAX_VALUES
+/// values.
+///
+/// For any other compiler, or to use names other than what's written in code,
+/// this can be specialized for the enum, with a static constexpr 'count' and a
+/// static constexpr 'names' array of std::string_view.
+template <typename EnumClass>
+struct EnumTraits {
+  static_assert(std::is_enum<EnumClass>::value,
+                "EnumTraits - Template parameter EnumClass must be an enum.");
+
+  /// The number of values in the enum.
+  static constexpr int count = detail::enumCount<EnumClass>(
+      std::make_index_sequence<detail::enumSearchRange<EnumClass>()>{});
+
+  static_assert(count > 0, "EnumTraits - Could not find any values for the "
+                           "enum, EnumTraits must be specialized for it.");
+
+  /// The names of the values in the enum, in order.
+  static constexpr std::array<std::string_view, count> names =
+      detail::enumNames<EnumClass>(std::make_index_sequence<count>{});
+};
+
+/// \brief Returns the name of the given enum value.
+template <typename EnumClass>
+constexpr std::string_view enumName(const EnumClass value) noexcept {
+  return EnumTraits<EnumClass>::names[static_cast<std::size_t>(value)];
+}
+
+/// \brief Returns a hash of the names of the values of the enum, in order.
+///
+/// Any values being added, removed, renamed or reordered changes the hash, so
+/// it can be stored alongside data indexed by the enum, to tell whether it was
+/// written with the same layout of the enum that's being used to read it.
+template <typename EnumClass>
+constexpr std::uint64_t enumLayoutHash() noexcept {
+  // 64-bit FNV-1a, with each name followed by a null separator.
+  std::uint64_t retVal = 0xcbf29ce484222325ull;
+  for (std::string_view const name : EnumTraits<EnumClass>::names) {
+    for (char const c : name) {
+      retVal = (retVal ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    retVal *= 0x100000001b3ull;
+  }
+
+  return retVal;
+}
+
+} // namespace stec
+
+#endif // STEC_ENUM_TRAITS_HPP
@@ -0,0 +1,272 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_FIXED_POINT_SCALAR_SET_HPP
+#define STEC_FIXED_POINT_SCALAR_SET_HPP
+
+#include "../fixed-point/fixed_point.hpp"
+#include "scalar_set.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace stec {
+
+namespace detail {
+
+template <typename T>
+struct IsFixedPoint : std::false_type {};
+
+template <typename T, int8_t Precision>
+struct IsFixedPoint<FixedPoint<T, Precision>> : std::true_type {
+  /// The underlying type of the FixedPoint.
+  using raw_type = T;
+
+  /// The number of precision digits of the FixedPoint.
+  static constexpr int precision = Precision;
+};
+
+/// \brief Returns 10 to the power of the exponent, as T.
+template <typename T>
+constexpr T powerOfTen(int exponent) noexcept {
+  T retVal = 1;
+  for (int i = 0; i < exponent; i++) {
+    retVal *= 10;
+  }
+  return retVal;
+}
+
+/// \brief The type products of raw values of T are taken in, so that they
+/// don't overflow before being scaled back down.
+template <typename T>
+using FixedPointProduct = typename std::conditional<
+    (sizeof(T) < sizeof(std::int64_t)),
+    typename std::conditional<std::is_signed<T>::value, std::int64_t,
+                              std::uint64_t>::type,
+    T>::type;
+
+/// \brief Returns the value as a raw value of FixedPoint<T, Precision>.
+///
+/// Another FixedPoint only has its raw value rescaled, by a power of ten that
+/// is a compile-time constant, while a scalar is multiplied by the precision
+/// multiplier, as when constructing a FixedPoint from it.
+template <typename T, int8_t Precision, typename Y>
+constexpr T toFixedPointRaw(const Y value) noexcept {
+  if constexpr (IsFixedPoint<Y>::value) {
+    using Info = IsFixedPoint<Y>;
+    constexpr int cShift = Precision - Info::precision;
+    if constexpr (cShift > 0) {
+      return static_cast<T>(value.getRaw() * powerOfTen<T>(cShift));
+    } else if constexpr (cShift < 0) {
+      return static_cast<T>(value.getRaw() /
+                            powerOfTen<typename Info::raw_type>(-cShift));
+    } else {
+      return static_cast<T>(value.getRaw());
+    }
+  } else {
+    return static_cast<T>(value * powerOfTen<T>(Precision));
+  }
+}
+
+} // namespace detail
+
+/// \brief The arithmetic policy for an EnumeratedScalarSet of FixedPoint
+/// values, which works directly on the raw, underlying integers.
+///
+/// Rather than each value being rescaled on its own, as when using the
+/// FixedPoint operators, the scale between the two sides is worked out once
+/// for the whole set, leaving plain integer loops over the raw values for the
+/// compiler to vectorize. Scalar operands are converted to a raw value once
+/// for the whole set.
+///
+/// The other side can be a FixedPoint of any precision, or a scalar. Products
+/// and quotients of two FixedPoint values are taken in a wider integer, and
+/// scaled back to the precision of the set.
+struct FixedPointArithmetic {
+  template <typename T, int8_t Precision, typename Y>
+  static void add(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                  int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void subtract(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                       int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void multiply(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                       int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void divide(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                     int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void add(FixedPoint<T, Precision> *lhs, const Y rhs,
+                  int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void subtract(FixedPoint<T, Precision> *lhs, const Y rhs,
+                       int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void multiply(FixedPoint<T, Precision> *lhs, const Y rhs,
+                       int count) noexcept;
+
+  template <typename T, int8_t Precision, typename Y>
+  static void divide(FixedPoint<T, Precision> *lhs, const Y rhs,
+                     int count) noexcept;
+
+private:
+  /// \brief Returns the raw value multiplied by the other value, which for
+  /// another FixedPoint is scaled back down by its precision multiplier.
+  template <typename T, typename Y>
+  static T multiplyRaw(const T raw, const Y rhs) noexcept;
+
+  /// \brief Returns the raw value divided by the other value, which for
+  /// another FixedPoint is first scaled up by its precision multiplier.
+  template <typename T, typename Y>
+  static T divideRaw(const T raw, const Y rhs) noexcept;
+};
+
+/// \brief Allows FixedPoint values to be used in an EnumeratedScalarSet, using
+/// FixedPointArithmetic by default.
+template <typename T, int8_t Precision>
+struct ScalarSetValueTraits<FixedPoint<T, Precision>> {
+  static_assert(Precision >= 0, "ScalarSetValueTraits - FixedPoint values "
+                                "must have a non-negative precision.");
+
+  static constexpr bool isSupported = true;
+
+  using Arithmetic = FixedPointArithmetic;
+
+  static constexpr bool isFixedPoint = true;
+
+  using raw_type = T;
+
+  static constexpr int precision = Precision;
+
+  static T toRaw(const FixedPoint<T, Precision> value) noexcept {
+    return value.getRaw();
+  }
+
+  /// \brief Returns the value as a double, for sets of scalars to operate
+  /// with.
+  static double toScalar(const FixedPoint<T, Precision> value) noexcept {
+    return static_cast<double>(value.getRaw()) /
+           detail::powerOfTen<double>(Precision);
+  }
+};
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::add(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                               int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] = FixedPoint<T, Precision>::fromRaw(
+        lhs[i].getRaw() + detail::toFixedPointRaw<T, Precision>(rhs[i]));
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::subtract(FixedPoint<T, Precision> *lhs,
+                                    const Y *rhs, int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] = FixedPoint<T, Precision>::fromRaw(
+        lhs[i].getRaw() - detail::toFixedPointRaw<T, Precision>(rhs[i]));
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::multiply(FixedPoint<T, Precision> *lhs,
+                                    const Y *rhs, int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] = FixedPoint<T, Precision>::fromRaw(
+        multiplyRaw(lhs[i].getRaw(), rhs[i]));
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::divide(FixedPoint<T, Precision> *lhs, const Y *rhs,
+                                  int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] =
+        FixedPoint<T, Precision>::fromRaw(divideRaw(lhs[i].getRaw(), rhs[i]));
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::add(FixedPoint<T, Precision> *lhs, const Y rhs,
+                               int count) noexcept {
+  T const raw = detail::toFixedPointRaw<T, Precision>(rhs);
+  for (int i = 0; i < count; i++) {
+    lhs[i] = FixedPoint<T, Precision>::fromRaw(lhs[i].getRaw() + raw);
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::subtract(FixedPoint<T, Precision> *lhs, const Y rhs,
+                                    int count) noexcept {
+  T const raw = detail::toFixedPointRaw<T, Precision>(rhs);
+  for (int i = 0; i < count; i++) {
+    lhs[i] = FixedPoint<T, Precision>::fromRaw(lhs[i].getRaw() - raw);
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::multiply(FixedPoint<T, Precision> *lhs, const Y rhs,
+                                    int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] =
+        FixedPoint<T, Precision>::fromRaw(multiplyRaw(lhs[i].getRaw(), rhs));
+  }
+}
+
+template <typename T, int8_t Precision, typename Y>
+void FixedPointArithmetic::divide(FixedPoint<T, Precision> *lhs, const Y rhs,
+                                  int count) noexcept {
+  for (int i = 0; i < count; i++) {
+    lhs[i] =
+        FixedPoint<T, Precision>::fromRaw(divideRaw(lhs[i].getRaw(), rhs));
+  }
+}
+
+template <typename T, typename Y>
+T FixedPointArithmetic::multiplyRaw(const T raw, const Y rhs) noexcept {
+  if constexpr (detail::IsFixedPoint<Y>::value) {
+    using Product = detail::FixedPointProduct<T>;
+    constexpr Product cScale =
+        detail::powerOfTen<Product>(detail::IsFixedPoint<Y>::precision);
+    return static_cast<T>(static_cast<Product>(raw) *
+                          static_cast<Product>(rhs.getRaw()) / cScale);
+  } else {
+    return static_cast<T>(raw * rhs);
+  }
+}
+
+template <typename T, typename Y>
+T FixedPointArithmetic::divideRaw(const T raw, const Y rhs) noexcept {
+  if constexpr (detail::IsFixedPoint<Y>::value) {
+    using Product = detail::FixedPointProduct<T>;
+    constexpr Product cScale =
+        detail::powerOfTen<Product>(detail::IsFixedPoint<Y>::precision);
+    return static_cast<T>(static_cast<Product>(raw) * cScale /
+                          static_cast<Product>(rhs.getRaw()));
+  } else {
+    return static_cast<T>(raw / rhs);
+  }
+}
+
+} // namespace stec
+
+#endif // STEC_FIXED_POINT_SCALAR_SET_HPP
@@ -0,0 +1,462 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_INDEXED_POPULATION_HPP
+#define STEC_INDEXED_POPULATION_HPP
+
+#include "scalar_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stec {
+
+namespace detail {
+
+/// \brief An index of one field of a population, for types of a single byte,
+/// with a list of entities for each possible value.
+///
+/// Inserting and erasing are constant time, with each entity remembering
+/// where it is in its list. A range is visited list by list, in value order.
+template <typename T>
+class BucketIndex {
+public:
+  void insert(std::uint32_t entity, T value) {
+    std::vector<std::uint32_t> &bucket = buckets[bucketOf(value)];
+    if (positions.size() <= entity) {
+      positions.resize(entity + 1);
+    }
+    positions[entity] = static_cast<std::uint32_t>(bucket.size());
+    bucket.push_back(entity);
+  }
+
+  void erase(std::uint32_t entity, T value) noexcept {
+    std::vector<std::uint32_t> &bucket = buckets[bucketOf(value)];
+    std::uint32_t const position = positions[entity];
+    bucket[position] = bucket.back();
+    positions[bucket[position]] = position;
+    bucket.pop_back();
+  }
+
+  std::size_t count(T lowest, T highest) const noexcept {
+    std::size_t retVal = 0;
+    for (int i = bucketOf(lowest); i <= bucketOf(highest); i++) {
+      retVal += buckets[i].size();
+    }
+    return retVal;
+  }
+
+  template <typename Function>
+  void forEach(T lowest, T highest, Function &&function) const {
+    for (int i = bucketOf(lowest); i <= bucketOf(highest); i++) {
+      for (std::uint32_t const entity : buckets[i]) {
+        function(entity);
+      }
+    }
+  }
+
+private:
+  static int bucketOf(T value) noexcept {
+    return static_cast<int>(value) -
+           static_cast<int>(std::numeric_limits<T>::min());
+  }
+
+  std::array<std::vector<std::uint32_t>, 256> buckets;
+  /// Where each entity is in the list for its value.
+  std::vector<std::uint32_t> positions;
+};
+
+/// \brief An index of one field of a population, as a column of the values
+/// sorted along with their entities.
+///
+/// A range is found with two binary searches, and is then contiguous.
+/// Inserting and erasing find their place with a binary search, and then
+/// shift the rest of the column along.
+///
+/// NaN values have no place in the order, so are left out of the column.
+template <typename T>
+class SortedIndex {
+public:
+  void insert(std::uint32_t entity, T value) {
+    if (value != value) {
+      return;
+    }
+    Entry const entry{value, entity};
+    column.insert(std::lower_bound(column.begin(), column.end(), entry),
+                  entry);
+  }
+
+  void erase(std::uint32_t entity, T value) noexcept {
+    if (value != value) {
+      return;
+    }
+    Entry const entry{value, entity};
+    auto const it = std::lower_bound(column.begin(), column.end(), entry);
+    if (it != column.end() && !(entry < *it)) {
+      column.erase(it);
+    }
+  }
+
+  std::size_t count(T lowest, T highest) const noexcept {
+    auto const range = find(lowest, highest);
+    return static_cast<std::size_t>(range.second - range.first);
+  }
+
+  template <typename Function>
+  void forEach(T lowest, T highest, Function &&function) const {
+    auto const range = find(lowest, highest);
+    for (auto it = range.first; it != range.second; ++it) {
+      function(it->entity);
+    }
+  }
+
+private:
+  struct Entry {
+    T value;
+    std::uint32_t entity;
+
+    bool operator<(const Entry &rhs) const noexcept {
+      return value < rhs.value || (!(rhs.value < value) && entity < rhs.entity);
+    }
+  };
+
+  using Iterator = typename std::vector<Entry>::const_iterator;
+
+  std::pair<Iterator, Iterator> find(T lowest, T highest) const noexcept {
+    if (!(lowest <= highest)) {
+      return {column.end(), column.end()};
+    }
+    return {std::lower_bound(
+                column.begin(), column.end(), lowest,
+                [](const Entry &lhs, T rhs) { return lhs.value < rhs; }),
+            std::upper_bound(
+                column.begin(), column.end(), highest,
+                [](T lhs, const Entry &rhs) { return lhs < rhs.value; })};
+  }
+
+  std::vector<Entry> column;
+};
+
+} // namespace detail
+
+/// \brief A population of EnumeratedScalarSets, one per entity, with optional
+/// indexes on any of the fields, for finding the entities whose values are
+/// within given ranges without looking at every entity.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet of each entity.
+///
+/// Fields of single-byte integer types are indexed with a list of entities for
+/// each possible value, which is updated in constant time. Other fields are
+/// indexed with a sorted column of values, which is updated with a binary
+/// search and a shift of the rest of the column.
+///
+/// Changing the values of an entity has to be done through the population, so
+/// that the indexes are kept up to date.
+///
+/// NaN values are never found by a query.
+template <typename ScalarSet>
+class IndexedPopulation {
+public:
+  using value_type = typename ScalarSet::value_type;
+  using enum_type = typename ScalarSet::enum_type;
+
+  /// \brief An inclusive range of values of a field.
+  struct Range {
+    enum_type field;
+    value_type lowest;
+    value_type highest;
+  };
+
+  /// \brief Returns the range of values of the field equal to the value.
+  static Range equalTo(enum_type field, value_type value) noexcept {
+    return {field, value, value};
+  }
+
+  /// \brief Returns the range of values of the field of at least the value.
+  static Range atLeast(enum_type field, value_type value) noexcept {
+    return {field, value, highestValue()};
+  }
+
+  /// \brief Returns the range of values of the field of at most the value.
+  static Range atMost(enum_type field, value_type value) noexcept {
+    return {field, lowestValue(), value};
+  }
+
+  /// \brief Returns the range of values of the field greater than the value.
+  static Range greaterThan(enum_type field, value_type value) noexcept;
+
+  /// \brief Returns the range of values of the field less than the value.
+  static Range lessThan(enum_type field, value_type value) noexcept;
+
+  /// \brief Returns the range of values of the field between the two values,
+  /// inclusive.
+  static Range between(enum_type field, value_type lowest,
+                       value_type highest) noexcept {
+    return {field, lowest, highest};
+  }
+
+  /// \brief Returns the number of entities.
+  std::uint32_t size() const noexcept {
+    return static_cast<std::uint32_t>(sets.size());
+  }
+
+  /// \brief Returns the set of the entity.
+  const ScalarSet &operator[](std::uint32_t entity) const noexcept {
+    return sets[entity];
+  }
+
+  /// \brief Adds an entity to the end of the population.
+  /// \return The index of the new entity.
+  std::uint32_t push_back(const ScalarSet &set);
+
+  /// \brief Removes the entity, with the last entity taking its index.
+  void erase(std::uint32_t entity);
+
+  /// \brief Changes one value of the entity, updating that field's index.
+  void set(std::uint32_t entity, enum_type field, value_type value);
+
+  /// \brief Changes all of the values of the entity, updating the indexes of
+  /// the fields that have changed.
+  void assign(std::uint32_t entity, const ScalarSet &set);
+
+  /// \brief Builds an index for the field, if it doesn't have one.
+  void addIndex(enum_type field);
+
+  /// \brief Removes the index for the field.
+  void removeIndex(enum_type field) noexcept {
+    indexes[toIndex(field)].reset();
+  }
+
+  /// \brief Returns whether the field has an index.
+  bool hasIndex(enum_type field) const noexcept {
+    return indexes[toIndex(field)].has_value();
+  }
+
+  /// \brief Returns the number of entities with the field in the range,
+  /// scanning every entity if the field has no index.
+  std::size_t count(const Range &range) const noexcept;
+
+  /// \brief Finds all of the entities with every one of the ranges matching.
+  /// \param ranges The ranges to match.
+  /// \param out The vector the indices of the matching entities are appended
+  /// to, in no particular order.
+  ///
+  /// Of the ranges on indexed fields, the one matching the fewest entities is
+  /// looked up in its index, and only those entities are checked against the
+  /// rest of the ranges, so that the cost follows the number of entities
+  /// matched rather than the size of the population. Only if none of the
+  /// ranges are on indexed fields is every entity checked.
+  void query(std::initializer_list<Range> ranges,
+             std::vector<std::uint32_t> &out) const;
+
+private:
+  using FieldIndex = typename std::conditional<
+      std::is_integral<value_type>::value && sizeof(value_type) == 1,
+      detail::BucketIndex<value_type>,
+      detail::SortedIndex<value_type>>::type;
+
+  static value_type lowestValue() noexcept {
+    return std::numeric_limits<value_type>::lowest();
+  }
+
+  static value_type highestValue() noexcept {
+    if constexpr (std::numeric_limits<value_type>::has_infinity) {
+      return std::numeric_limits<value_type>::infinity();
+    } else {
+      return std::numeric_limits<value_type>::max();
+    }
+  }
+
+  static int toIndex(enum_type field) noexcept {
+    return static_cast<int>(field);
+  }
+
+  /// \brief Returns whether the value is in the range, which is never the
+  /// case for NaN values or bounds.
+  static bool contains(const Range &range, value_type value) noexcept {
+    return range.lowest <= value && value <= range.highest;
+  }
+
+  std::vector<ScalarSet> sets;
+  std::array<std::optional<FieldIndex>, ScalarSet::size()> indexes;
+};
+
+template <typename ScalarSet>
+typename IndexedPopulation<ScalarSet>::Range
+IndexedPopulation<ScalarSet>::greaterThan(enum_type field,
+                                          value_type value) noexcept {
+  if constexpr (std::is_floating_point<value_type>::value) {
+    return {field, std::nextafter(value, highestValue()), highestValue()};
+  } else {
+    // An empty range when there's nothing greater.
+    return value == highestValue()
+               ? Range{field, highestValue(), lowestValue()}
+               : Range{field, static_cast<value_type>(value + 1),
+                       highestValue()};
+  }
+}
+
+template <typename ScalarSet>
+typename IndexedPopulation<ScalarSet>::Range
+IndexedPopulation<ScalarSet>::lessThan(enum_type field,
+                                       value_type value) noexcept {
+  if constexpr (std::is_floating_point<value_type>::value) {
+    return {field, lowestValue(), std::nextafter(value, lowestValue())};
+  } else {
+    return value == lowestValue()
+               ? Range{field, highestValue(), lowestValue()}
+               : Range{field, lowestValue(),
+                       static_cast<value_type>(value - 1)};
+  }
+}
+
+template <typename ScalarSet>
+std::uint32_t IndexedPopulation<ScalarSet>::push_back(const ScalarSet &set) {
+  std::uint32_t const entity = size();
+  sets.push_back(set);
+  for (int i = 0; i < ScalarSet::size(); i++) {
+    if (indexes[i]) {
+      indexes[i]->insert(entity, set.data()[i]);
+    }
+  }
+
+  return entity;
+}
+
+template <typename ScalarSet>
+void IndexedPopulation<ScalarSet>::erase(std::uint32_t entity) {
+  std::uint32_t const last = size() - 1;
+  for (int i = 0; i < ScalarSet::size(); i++) {
+    if (indexes[i]) {
+      indexes[i]->erase(entity, sets[entity].data()[i]);
+      if (entity != last) {
+        indexes[i]->erase(last, sets[last].data()[i]);
+        indexes[i]->insert(entity, sets[last].data()[i]);
+      }
+    }
+  }
+
+  sets[entity] = sets[last];
+  sets.pop_back();
+}
+
+template <typename ScalarSet>
+void IndexedPopulation<ScalarSet>::set(std::uint32_t entity, enum_type field,
+                                       value_type value) {
+  value_type &current = sets[entity][field];
+  std::optional<FieldIndex> &index = indexes[toIndex(field)];
+  if (index) {
+    index->erase(entity, current);
+    index->insert(entity, value);
+  }
+  current = value;
+}
+
+template <typename ScalarSet>
+void IndexedPopulation<ScalarSet>::assign(std::uint32_t entity,
+                                          const ScalarSet &set) {
+  for (int i = 0; i < ScalarSet::size(); i++) {
+    if (indexes[i] && !(set.data()[i] == sets[entity].data()[i])) {
+      indexes[i]->erase(entity, sets[entity].data()[i]);
+      indexes[i]->insert(entity, set.data()[i]);
+    }
+  }
+  sets[entity] = set;
+}
+
+template <typename ScalarSet>
+void IndexedPopulation<ScalarSet>::addIndex(enum_type field) {
+  std::optional<FieldIndex> &index = indexes[toIndex(field)];
+  if (index) {
+    return;
+  }
+
+  index.emplace();
+  for (std::uint32_t entity = 0; entity < size(); entity++) {
+    index->insert(entity, sets[entity][field]);
+  }
+}
+
+template <typename ScalarSet>
+std::size_t
+IndexedPopulation<ScalarSet>::count(const Range &range) const noexcept {
+  std::optional<FieldIndex> const &index = indexes[toIndex(range.field)];
+  if (index) {
+    return !(range.lowest <= range.highest)
+               ? 0
+               : index->count(range.lowest, range.highest);
+  }
+
+  std::size_t retVal = 0;
+  for (const ScalarSet &set : sets) {
+    retVal += contains(range, set[range.field]);
+  }
+  return retVal;
+}
+
+template <typename ScalarSet>
+void IndexedPopulation<ScalarSet>::query(
+    std::initializer_list<Range> ranges,
+    std::vector<std::uint32_t> &out) const {
+  // The indexed range matching the fewest entities.
+  const Range *driver = nullptr;
+  std::size_t driverCount = 0;
+  for (const Range &range : ranges) {
+    if (hasIndex(range.field)) {
+      std::size_t const rangeCount = count(range);
+      if (driver == nullptr || rangeCount < driverCount) {
+        driver = &range;
+        driverCount = rangeCount;
+      }
+    }
+  }
+
+  auto const matches = [&](std::uint32_t entity) {
+    for (const Range &range : ranges) {
+      if (&range != driver && !contains(range, sets[entity][range.field])) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  if (driver == nullptr) {
+    for (std::uint32_t entity = 0; entity < size(); entity++) {
+      if (matches(entity)) {
+        out.push_back(entity);
+      }
+    }
+  } else if (driverCount != 0) {
+    indexes[toIndex(driver->field)]->forEach(
+        driver->lowest, driver->highest, [&](std::uint32_t entity) {
+          if (matches(entity)) {
+            out.push_back(entity);
+          }
+        });
+  }
+}
+
+} // namespace stec
+
+#endif // STEC_INDEXED_POPULATION_HPP
@@ -0,0 +1,85 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "indexed_population.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+enum class Field {
+  A,
+  B,
+};
+
+using Set = stec::EnumeratedScalarSet<float, Field>;
+using Population = stec::IndexedPopulation<Set>;
+
+/// \brief Checks the population gives the same answers with and without an
+/// index on the field.
+void check(Population &population, const Population::Range &range,
+           std::size_t expected) {
+  population.removeIndex(range.field);
+  assert(population.count(range) == expected);
+  std::vector<std::uint32_t> found;
+  population.query({range}, found);
+  assert(found.size() == expected);
+
+  population.addIndex(range.field);
+  assert(population.count(range) == expected);
+  found.clear();
+  population.query({range}, found);
+  assert(found.size() == expected);
+}
+
+int main() {
+  float const nan = std::numeric_limits<float>::quiet_NaN();
+
+  Population population;
+  for (float const value : {9.f, 5.f, 0.5f, nan, 3.f, 7.f, 10.f, 6.f}) {
+    Set set;
+    set[Field::A] = value;
+    population.push_back(set);
+  }
+  population.addIndex(Field::A);
+
+  check(population, Population::between(Field::A, 0, 10), 7);
+  check(population, Population::equalTo(Field::A, 3), 1);
+  check(population, Population::atLeast(Field::A, 6), 4);
+  check(population, Population::equalTo(Field::A, nan), 0);
+  check(population, Population::between(Field::A, nan, 10), 0);
+
+  // Setting values to NaN takes them out of every range, and setting them
+  // back puts them in again.
+  population.set(0, Field::A, nan);
+  population.set(4, Field::A, nan);
+  check(population, Population::between(Field::A, 0, 10), 5);
+  check(population, Population::equalTo(Field::A, 3), 0);
+
+  population.set(3, Field::A, 3);
+  population.set(4, Field::A, 3);
+  check(population, Population::equalTo(Field::A, 3), 2);
+  check(population, Population::between(Field::A, 0, 10), 7);
+
+  // Erasing entities with NaN values, and moving the last into their place.
+  population.erase(0);
+  population.erase(population.size() - 1);
+  check(population, Population::between(Field::A, 0, 10), 6);
+  check(population, Population::atMost(Field::A, 5), 4);
+
+  return 0;
+}
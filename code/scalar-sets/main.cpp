@@ -14,10 +14,11 @@
     limitations under the License.
 */
 
+#include "saturating_arithmetic.hpp"
 #include "scalar_set.hpp"
+#include "scalar_set_format.hpp"
 
 #include <iostream>
-#include <string>
 
 enum class Special {
   Strength,
@@ -28,26 +29,15 @@ enum class Special {
   Agility,
   Luck,
 };
-constexpr std::underlying_type<Special>::type cNumSpecial =
-    static_cast<std::underlying_type<Special>::type>(Special::Luck) + 1;
-
-using SpecialSet = stec::EnumeratedScalarSet<int8_t, Special, cNumSpecial>;
-using SpecialSetf = stec::EnumeratedScalarSet<float, Special, cNumSpecial>;
-
-std::string to_string(SpecialSet special) {
-  std::string retVal;
-  retVal.reserve(100);
-
-  retVal = "Strength " + std::to_string(special[Special::Strength]);
-  retVal += "\nPerception " + std::to_string(special[Special::Perception]);
-  retVal += "\nEndurance " + std::to_string(special[Special::Endurance]);
-  retVal += "\nCharisma " + std::to_string(special[Special::Charisma]);
-  retVal += "\nIntelligence " + std::to_string(special[Special::Intelligence]);
-  retVal += "\nAgility " + std::to_string(special[Special::Agility]);
-  retVal += "\nLuck " + std::to_string(special[Special::Luck]);
-  retVal += '\n';
-
-  return retVal;
+
+using SpecialSet = stec::SaturatingEnumeratedScalarSet<int8_t, Special>;
+using SpecialSetf = stec::EnumeratedScalarSet<float, Special>;
+
+std::ostream &operator<<(std::ostream &out, SpecialSet const &special) {
+  char buffer[stec::formattedSizeMax<SpecialSet>()];
+  char *end = stec::formatTo(buffer, buffer + sizeof(buffer), special).ptr;
+
+  return out.write(buffer, end - buffer);
 }
 
 int main() {
@@ -68,8 +58,8 @@ int main() {
   SpecialSet result = (base + perks + modifiers) * multiplier;
 
   std::cout << "\nBase: \n"
-            << to_string(base) << "\nPerks: \n"
-            << to_string(perks) << "\nModifiers: \n"
-            << to_string(modifiers) << "\nResult: \n"
-            << to_string(result) << std::endl;
+            << base << "\nPerks: \n"
+            << perks << "\nModifiers: \n"
+            << modifiers << "\nResult: \n"
+            << result << std::endl;
 }
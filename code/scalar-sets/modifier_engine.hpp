@@ -0,0 +1,426 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_MODIFIER_ENGINE_HPP
+#define STEC_MODIFIER_ENGINE_HPP
+
+#include "scalar_set.hpp"
+#include "scalar_set_reductions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace stec {
+
+/// \brief Refers to a modifier added to a ModifierEngine. Once the modifier
+/// has expired or been removed, the handle no longer refers to anything, even
+/// if its slot is reused by another modifier.
+struct ModifierHandle {
+  /// The index of the modifier's slot.
+  std::uint32_t index;
+  /// The generation of the slot when the modifier was added.
+  std::uint32_t generation;
+};
+
+/// \brief Applies timed additive and multiplicative modifiers, such as buffs
+/// and debuffs, to the base sets of a number of entities.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet of base values, also
+/// used for additive modifiers.
+/// \tparam MultiplierSet The type of the EnumeratedScalarSet used for
+/// multiplicative modifiers.
+///
+/// The total for an entity is (base + additive) * (1 + multiplicative), where
+/// additive is the sum of its additive modifiers and multiplicative the sum of
+/// its multiplicative ones, so that a +10% and a +20% modifier make +30%. The
+/// sums are kept up to date as modifiers come and go, in 64-bit integers or
+/// doubles, so a modifier expiring only subtracts its own contribution rather
+/// than everything being summed up again. The totals are worked out with the
+/// arithmetic of the ScalarSet, such as saturating.
+///
+/// Expiry is tracked with a hierarchical timer wheel, of 4 levels of 64 slots,
+/// so each tick only visits the modifiers expiring on it, plus, every 64
+/// ticks, moving a slot of longer-lived modifiers down a level.
+template <typename ScalarSet,
+          typename MultiplierSet =
+              EnumeratedScalarSet<float, typename ScalarSet::enum_type,
+                                  ScalarSet::size()>>
+class ModifierEngine {
+public:
+  /// \brief Constructor
+  /// \param numEntities The number of entities to start with, each with a base
+  /// set of 0.
+  explicit ModifierEngine(std::uint32_t numEntities = 0);
+
+  /// \brief Adds an entity.
+  /// \param base The base values of the entity.
+  /// \return The index of the new entity.
+  std::uint32_t addEntity(const ScalarSet &base);
+
+  /// \brief Returns the number of entities.
+  std::uint32_t numEntities() const noexcept {
+    return static_cast<std::uint32_t>(entities.size());
+  }
+
+  /// \brief Returns the base values of the entity.
+  const ScalarSet &base(std::uint32_t entity) const noexcept {
+    return entities[entity].base;
+  }
+
+  /// \brief Replaces the base values of the entity, keeping its modifiers.
+  void setBase(std::uint32_t entity, const ScalarSet &base) noexcept;
+
+  /// \brief Returns the values of the entity with all of its current
+  /// modifiers applied.
+  const ScalarSet &total(std::uint32_t entity) const noexcept {
+    return entities[entity].total;
+  }
+
+  /// \brief Adds a modifier to the entity.
+  /// \param entity The index of the entity to modify.
+  /// \param additive The values added to the entity's base.
+  /// \param multiplier The fractions the entity's values are increased by,
+  /// such as 0.1 for +10%.
+  /// \param duration The number of ticks until the modifier expires, or 0 for
+  /// a modifier that lasts until removed.
+  /// \return The handle of the new modifier.
+  ModifierHandle add(std::uint32_t entity, const ScalarSet &additive,
+                     const MultiplierSet &multiplier, std::uint32_t duration);
+
+  /// \brief Adds a modifier to the entity that only adds to its values.
+  ModifierHandle addAdditive(std::uint32_t entity, const ScalarSet &additive,
+                             std::uint32_t duration) {
+    return add(entity, additive, MultiplierSet(0), duration);
+  }
+
+  /// \brief Adds a modifier to the entity that only multiplies its values.
+  ModifierHandle addMultiplicative(std::uint32_t entity,
+                                   const MultiplierSet &multiplier,
+                                   std::uint32_t duration) {
+    return add(entity, ScalarSet(0), multiplier, duration);
+  }
+
+  /// \brief Returns whether the modifier is still active.
+  bool contains(ModifierHandle handle) const noexcept;
+
+  /// \brief Removes the modifier before it expires.
+  /// \return True if the modifier was still active and has been removed.
+  bool remove(ModifierHandle handle) noexcept;
+
+  /// \brief Advances time by one tick, expiring all of the modifiers due to
+  /// expire on it.
+  void tick() noexcept;
+
+  /// \brief Returns the number of ticks that have passed.
+  std::uint64_t now() const noexcept { return currentTick; }
+
+  /// \brief Returns the number of modifiers currently active.
+  std::size_t numModifiers() const noexcept { return activeModifiers; }
+
+private:
+  using AdditiveSum =
+      EnumeratedScalarSet<SumType<typename ScalarSet::value_type>,
+                          typename ScalarSet::enum_type, ScalarSet::size()>;
+  using MultiplierSum =
+      EnumeratedScalarSet<SumType<typename MultiplierSet::value_type>,
+                          typename ScalarSet::enum_type, ScalarSet::size()>;
+
+  struct Entity {
+    ScalarSet base;
+    ScalarSet total;
+    AdditiveSum additive;
+    MultiplierSum multiplier;
+    /// Whether the total needs to be worked out again at the end of the tick.
+    bool dirty;
+  };
+
+  struct Modifier {
+    ScalarSet additive;
+    MultiplierSet multiplier;
+    /// The tick the modifier expires on, or 0 if it doesn't.
+    std::uint64_t expiry;
+    std::uint32_t entity;
+    std::uint32_t generation;
+    /// The wheel slot the modifier is listed in, or cNone if it isn't.
+    std::uint32_t slot;
+    /// The neighbouring modifiers in the slot's list, or the free list.
+    std::uint32_t prev;
+    std::uint32_t next;
+    bool active;
+  };
+
+  static constexpr std::uint32_t cNone = 0xffffffff;
+  static constexpr int cSlotBits = 6;
+  static constexpr int cNumSlots = 1 << cSlotBits;
+  static constexpr int cNumLevels = 4;
+  /// The longest delay that the wheel can hold directly. Longer-lived
+  /// modifiers are placed at that delay, and moved on when they get there.
+  static constexpr std::uint64_t cMaxDelay =
+      (static_cast<std::uint64_t>(1) << (cSlotBits * cNumLevels)) - 1;
+
+  /// \brief Works out the total of the entity from its sums.
+  void recompose(Entity &entity) noexcept;
+
+  /// \brief Adds or subtracts the modifier's contribution to its entity's
+  /// sums.
+  void applyContribution(const Modifier &modifier, bool adding) noexcept;
+
+  /// \brief Lists the modifier in the wheel slot for its expiry.
+  void schedule(std::uint32_t index) noexcept;
+
+  /// \brief Removes the modifier from its wheel slot's list.
+  void unschedule(std::uint32_t index) noexcept;
+
+  /// \brief Moves every modifier in the slot down to the lower levels.
+  void cascade(int level) noexcept;
+
+  /// \brief Expires the modifier, freeing its slot.
+  void expire(std::uint32_t index) noexcept;
+
+  std::vector<Entity> entities;
+  std::vector<Modifier> modifiers;
+  /// The first modifier of each wheel slot, level-major.
+  std::array<std::uint32_t, cNumLevels * cNumSlots> wheel;
+  /// The first unused modifier slot.
+  std::uint32_t freeList = cNone;
+  /// The entities whose totals are out of date until the end of the tick.
+  std::vector<std::uint32_t> dirtyEntities;
+  std::uint64_t currentTick = 0;
+  std::size_t activeModifiers = 0;
+};
+
+template <typename ScalarSet, typename MultiplierSet>
+ModifierEngine<ScalarSet, MultiplierSet>::ModifierEngine(
+    std::uint32_t numEntities) {
+  wheel.fill(cNone);
+  for (std::uint32_t i = 0; i < numEntities; i++) {
+    addEntity(ScalarSet(0));
+  }
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+std::uint32_t
+ModifierEngine<ScalarSet, MultiplierSet>::addEntity(const ScalarSet &base) {
+  entities.push_back(
+      Entity{base, base, AdditiveSum(0), MultiplierSum(0), false});
+  return static_cast<std::uint32_t>(entities.size() - 1);
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::setBase(
+    std::uint32_t entity, const ScalarSet &base) noexcept {
+  entities[entity].base = base;
+  recompose(entities[entity]);
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+ModifierHandle ModifierEngine<ScalarSet, MultiplierSet>::add(
+    std::uint32_t entity, const ScalarSet &additive,
+    const MultiplierSet &multiplier, std::uint32_t duration) {
+  std::uint32_t index = freeList;
+  if (index != cNone) {
+    freeList = modifiers[index].next;
+  } else {
+    index = static_cast<std::uint32_t>(modifiers.size());
+    modifiers.emplace_back();
+    modifiers[index].generation = 0;
+  }
+
+  Modifier &modifier = modifiers[index];
+  modifier.additive = additive;
+  modifier.multiplier = multiplier;
+  modifier.expiry = duration == 0 ? 0 : currentTick + duration;
+  modifier.entity = entity;
+  modifier.slot = cNone;
+  modifier.active = true;
+  activeModifiers++;
+
+  applyContribution(modifier, true);
+  recompose(entities[entity]);
+  if (duration != 0) {
+    schedule(index);
+  }
+
+  return {index, modifier.generation};
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+bool ModifierEngine<ScalarSet, MultiplierSet>::contains(
+    ModifierHandle handle) const noexcept {
+  return handle.index < modifiers.size() &&
+         modifiers[handle.index].active &&
+         modifiers[handle.index].generation == handle.generation;
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+bool ModifierEngine<ScalarSet, MultiplierSet>::remove(
+    ModifierHandle handle) noexcept {
+  if (!contains(handle)) {
+    return false;
+  }
+
+  std::uint32_t const entity = modifiers[handle.index].entity;
+  unschedule(handle.index);
+  expire(handle.index);
+  recompose(entities[entity]);
+  return true;
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::tick() noexcept {
+  currentTick++;
+
+  // Each time a level wraps around, the next slot of the level above is due
+  // to be spread out over the levels below.
+  for (int level = 1; level < cNumLevels; level++) {
+    std::uint64_t const levelMask =
+        (static_cast<std::uint64_t>(1) << (cSlotBits * level)) - 1;
+    if ((currentTick & levelMask) != 0) {
+      break;
+    }
+    cascade(level);
+  }
+
+  std::uint32_t &head = wheel[currentTick & (cNumSlots - 1)];
+  while (head != cNone) {
+    std::uint32_t const index = head;
+    unschedule(index);
+    if (modifiers[index].expiry > currentTick) {
+      // A modifier placed at the maximum delay, with further to go.
+      schedule(index);
+      continue;
+    }
+
+    Entity &entity = entities[modifiers[index].entity];
+    expire(index);
+    if (!entity.dirty) {
+      entity.dirty = true;
+      dirtyEntities.push_back(modifiers[index].entity);
+    }
+  }
+
+  for (std::uint32_t const entity : dirtyEntities) {
+    recompose(entities[entity]);
+  }
+  dirtyEntities.clear();
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::recompose(
+    Entity &entity) noexcept {
+  MultiplierSum factor = entity.multiplier;
+  factor += 1;
+
+  entity.total = entity.base;
+  entity.total += entity.additive;
+  entity.total *= factor;
+  entity.dirty = false;
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::applyContribution(
+    const Modifier &modifier, bool adding) noexcept {
+  Entity &entity = entities[modifier.entity];
+  if (adding) {
+    entity.additive += modifier.additive;
+    entity.multiplier += modifier.multiplier;
+  } else {
+    entity.additive -= modifier.additive;
+    entity.multiplier -= modifier.multiplier;
+  }
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::schedule(
+    std::uint32_t index) noexcept {
+  Modifier &modifier = modifiers[index];
+  std::uint64_t const delay =
+      std::min(modifier.expiry - currentTick, cMaxDelay);
+  std::uint64_t const when = currentTick + delay;
+
+  // The lowest level whose slots cover the delay.
+  int level = 0;
+  while (level + 1 < cNumLevels &&
+         delay >= static_cast<std::uint64_t>(1) << (cSlotBits * (level + 1))) {
+    level++;
+  }
+  std::uint32_t const slot = static_cast<std::uint32_t>(
+      level * cNumSlots +
+      ((when >> (cSlotBits * level)) & (cNumSlots - 1)));
+
+  modifier.slot = slot;
+  modifier.prev = cNone;
+  modifier.next = wheel[slot];
+  if (wheel[slot] != cNone) {
+    modifiers[wheel[slot]].prev = index;
+  }
+  wheel[slot] = index;
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::unschedule(
+    std::uint32_t index) noexcept {
+  Modifier &modifier = modifiers[index];
+  if (modifier.slot == cNone) {
+    return;
+  }
+
+  if (modifier.prev != cNone) {
+    modifiers[modifier.prev].next = modifier.next;
+  } else {
+    wheel[modifier.slot] = modifier.next;
+  }
+  if (modifier.next != cNone) {
+    modifiers[modifier.next].prev = modifier.prev;
+  }
+  modifier.slot = cNone;
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::cascade(int level) noexcept {
+  std::uint32_t const slot = static_cast<std::uint32_t>(
+      level * cNumSlots +
+      ((currentTick >> (cSlotBits * level)) & (cNumSlots - 1)));
+
+  // Detached first, as modifiers with further to go may be listed back into
+  // the same level.
+  std::uint32_t index = wheel[slot];
+  wheel[slot] = cNone;
+  while (index != cNone) {
+    std::uint32_t const next = modifiers[index].next;
+    schedule(index);
+    index = next;
+  }
+}
+
+template <typename ScalarSet, typename MultiplierSet>
+void ModifierEngine<ScalarSet, MultiplierSet>::expire(
+    std::uint32_t index) noexcept {
+  Modifier &modifier = modifiers[index];
+  applyContribution(modifier, false);
+
+  modifier.active = false;
+  modifier.generation++;
+  modifier.next = freeList;
+  freeList = index;
+  activeModifiers--;
+}
+
+} // namespace stec
+
+#endif // STEC_MODIFIER_ENGINE_HPP
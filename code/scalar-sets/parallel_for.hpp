@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_PARALLEL_FOR_HPP
+#define STEC_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace stec {
+
+namespace detail {
+
+/// The fewest items given to each thread, below which the cost of starting a
+/// thread outweighs the work it would do.
+constexpr std::size_t cMinItemsPerThread = 16384;
+
+/// \brief Returns how many threads to split the items across.
+/// \param count The number of items.
+/// \param numThreads The most threads to use, or 0 for one per hardware
+/// thread.
+inline unsigned threadCount(std::size_t count, unsigned numThreads) noexcept {
+  if (numThreads == 0) {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  std::size_t const useful = std::max<std::size_t>(
+      (count + cMinItemsPerThread - 1) / cMinItemsPerThread, 1);
+
+  return static_cast<unsigned>(std::min<std::size_t>(numThreads, useful));
+}
+
+/// \brief Splits the range [0, count) into contiguous chunks, one per thread,
+/// calling function(thread, begin, end) for each, and waits for them all.
+///
+/// The calling thread does the first chunk itself, so a single chunk never
+/// starts a thread.
+template <typename Function>
+void parallelFor(std::size_t count, unsigned numThreads, Function &&function) {
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (unsigned thread = 1; thread < numThreads; thread++) {
+    threads.emplace_back([&, thread] {
+      function(thread, count * thread / numThreads,
+               count * (thread + 1) / numThreads);
+    });
+  }
+  function(0u, std::size_t{0}, count / numThreads);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace detail
+
+} // namespace stec
+
+#endif // STEC_PARALLEL_FOR_HPP
@@ -0,0 +1,354 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_PUBLISHED_POPULATION_HPP
+#define STEC_PUBLISHED_POPULATION_HPP
+
+#include "atomic_scalar_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace stec {
+
+/// \brief A population of EnumeratedScalarSets written by one thread and
+/// published for any number of other threads to read consistent views of,
+/// without locking.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet of each entity.
+///
+/// The sets are held in pages of around 4KB. The writer changes its own copy
+/// of the population, and each page it changes is copied the first time it
+/// is written to after a publish, so a publish only has to copy the changed
+/// pages, with the rest shared with the previous version.
+///
+/// Readers reading a version mark the epoch they started in, which is all
+/// they write, so reading never waits on the writer or other readers, and a
+/// reader sees a version that's entirely as one publish left it. The writer
+/// frees the pages replaced by a publish once no reader can still be reading
+/// the version they were part of.
+///
+/// Only one thread may use the writing functions at a time.
+template <typename ScalarSet>
+class PublishedPopulation {
+  /// The sets held in each page.
+  static constexpr std::size_t cPageSize =
+      std::max<std::size_t>(4096 / sizeof(ScalarSet), 1);
+
+  struct Page {
+    std::array<ScalarSet, cPageSize> sets;
+  };
+
+  /// A published version of the population, which never changes.
+  struct Version {
+    std::vector<const Page *> pages;
+    std::size_t count;
+    std::uint64_t number;
+  };
+
+  /// The epoch a reader is reading in, or cIdle if it isn't reading.
+  struct alignas(cCacheLineSize) ReaderSlot {
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<bool> taken;
+  };
+
+  static constexpr std::uint64_t cIdle =
+      std::numeric_limits<std::uint64_t>::max();
+
+public:
+  /// \brief A consistent view of a published version of the population.
+  ///
+  /// The version is kept from being freed until the view is destroyed, so
+  /// views should be short-lived.
+  class View {
+  public:
+    View(View &&other) noexcept
+        : slot(other.slot), version(other.version) {
+      other.slot = nullptr;
+    }
+
+    View(const View &) = delete;
+    View &operator=(const View &) = delete;
+    View &operator=(View &&) = delete;
+
+    ~View() {
+      if (slot != nullptr) {
+        slot->epoch.store(cIdle, std::memory_order_release);
+      }
+    }
+
+    /// \brief Returns the number of sets in the version.
+    std::size_t size() const noexcept { return version->count; }
+
+    /// \brief Returns the set of the entity.
+    const ScalarSet &operator[](std::size_t entity) const noexcept {
+      return version->pages[entity / cPageSize]->sets[entity % cPageSize];
+    }
+
+    /// \brief Returns the number of the publish that made the version.
+    std::uint64_t number() const noexcept { return version->number; }
+
+  private:
+    friend class PublishedPopulation;
+
+    View(ReaderSlot *readerSlot, const Version *published) noexcept
+        : slot(readerSlot), version(published) {}
+
+    ReaderSlot *slot;
+    const Version *version;
+  };
+
+  /// \brief A thread's registration as a reader of the population, which
+  /// must be used by one thread at a time, and only have one View at a time,
+  /// which has to be destroyed before the Reader is.
+  class Reader {
+  public:
+    Reader(Reader &&other) noexcept
+        : population(other.population), slot(other.slot) {
+      other.slot = nullptr;
+    }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+    Reader &operator=(Reader &&) = delete;
+
+    ~Reader() {
+      if (slot != nullptr) {
+        slot->taken.store(false, std::memory_order_release);
+      }
+    }
+
+    /// \brief Returns a view of the latest published version.
+    View read() const noexcept { return population->read(slot); }
+
+  private:
+    friend class PublishedPopulation;
+
+    Reader(const PublishedPopulation *owner, ReaderSlot *readerSlot) noexcept
+        : population(owner), slot(readerSlot) {}
+
+    const PublishedPopulation *population;
+    ReaderSlot *slot;
+  };
+
+  /// \brief Constructor, publishing the initial version.
+  /// \param numSets The number of sets to start with.
+  /// \param initial The value to start each set with.
+  /// \param maxReaders The most readers that can be registered at once.
+  explicit PublishedPopulation(std::size_t numSets = 0,
+                               const ScalarSet &initial = ScalarSet(),
+                               unsigned maxReaders = 64);
+
+  /// \brief Destructor, which must only happen once every Reader is gone.
+  ~PublishedPopulation();
+
+  PublishedPopulation(const PublishedPopulation &) = delete;
+  PublishedPopulation &operator=(const PublishedPopulation &) = delete;
+
+  /// \brief Registers a reader.
+  /// \return The reader, or nothing if maxReaders are already registered.
+  std::optional<Reader> addReader() noexcept;
+
+  /// \brief Returns the number of sets in the writer's copy.
+  std::size_t size() const noexcept { return count; }
+
+  /// \brief Returns the set of the entity in the writer's copy.
+  const ScalarSet &operator[](std::size_t entity) const noexcept {
+    return pages[entity / cPageSize]->sets[entity % cPageSize];
+  }
+
+  /// \brief Returns the set of the entity in the writer's copy to change,
+  /// copying its page first if it's shared with a published version.
+  ScalarSet &write(std::size_t entity);
+
+  /// \brief Adds a set to the end of the writer's copy.
+  void push_back(const ScalarSet &set);
+
+  /// \brief Publishes the writer's copy for readers, if it has changed since
+  /// the last publish, then frees what readers are done with.
+  /// \return The number of the latest published version.
+  std::uint64_t publish();
+
+  /// \brief Frees the versions and pages that were replaced by publishes, and
+  /// that no reader can still be reading.
+  /// \return The number of versions still waiting to be freed.
+  std::size_t reclaim() noexcept;
+
+private:
+  /// A version that's been replaced, along with the pages replaced in the
+  /// version that followed it.
+  struct Retired {
+    const Version *version;
+    std::vector<const Page *> pages;
+    /// The epoch that readers have to be in, or past, to not be reading it.
+    std::uint64_t epoch;
+  };
+
+  View read(ReaderSlot *slot) const noexcept;
+
+  /// The writer's copy of the pages.
+  std::vector<Page *> pages;
+  /// Whether each of the writer's pages is also part of the latest version.
+  std::vector<bool> published;
+  /// The pages replaced since the last publish.
+  std::vector<const Page *> replaced;
+  std::size_t count;
+  bool changed = false;
+
+  std::atomic<const Version *> current;
+  std::atomic<std::uint64_t> epoch{0};
+  std::unique_ptr<ReaderSlot[]> readers;
+  unsigned numReaders;
+  std::vector<Retired> retired;
+};
+
+template <typename ScalarSet>
+PublishedPopulation<ScalarSet>::PublishedPopulation(std::size_t numSets,
+                                                    const ScalarSet &initial,
+                                                    unsigned maxReaders)
+    : count(0), readers(new ReaderSlot[maxReaders]), numReaders(maxReaders) {
+  for (unsigned i = 0; i < numReaders; i++) {
+    readers[i].epoch.store(cIdle, std::memory_order_relaxed);
+    readers[i].taken.store(false, std::memory_order_relaxed);
+  }
+
+  current.store(new Version{{}, 0, 0}, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < numSets; i++) {
+    push_back(initial);
+  }
+  publish();
+}
+
+template <typename ScalarSet>
+PublishedPopulation<ScalarSet>::~PublishedPopulation() {
+  for (Retired &old : retired) {
+    for (const Page *page : old.pages) {
+      delete page;
+    }
+    delete old.version;
+  }
+  for (const Page *page : replaced) {
+    delete page;
+  }
+  for (Page *page : pages) {
+    delete page;
+  }
+  delete current.load(std::memory_order_relaxed);
+}
+
+template <typename ScalarSet>
+std::optional<typename PublishedPopulation<ScalarSet>::Reader>
+PublishedPopulation<ScalarSet>::addReader() noexcept {
+  for (unsigned i = 0; i < numReaders; i++) {
+    bool expected = false;
+    if (readers[i].taken.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acquire)) {
+      return Reader(this, &readers[i]);
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename ScalarSet>
+ScalarSet &PublishedPopulation<ScalarSet>::write(std::size_t entity) {
+  std::size_t const index = entity / cPageSize;
+  if (published[index]) {
+    // Readers may be reading the page, so it's replaced with a copy.
+    Page *const copy = new Page(*pages[index]);
+    replaced.push_back(pages[index]);
+    pages[index] = copy;
+    published[index] = false;
+  }
+  changed = true;
+
+  return pages[index]->sets[entity % cPageSize];
+}
+
+template <typename ScalarSet>
+void PublishedPopulation<ScalarSet>::push_back(const ScalarSet &set) {
+  if (count % cPageSize == 0) {
+    pages.push_back(new Page());
+    published.push_back(false);
+  }
+  count++;
+  write(count - 1) = set;
+}
+
+template <typename ScalarSet>
+std::uint64_t PublishedPopulation<ScalarSet>::publish() {
+  const Version *const previous = current.load(std::memory_order_relaxed);
+  if (!changed) {
+    reclaim();
+    return previous->number;
+  }
+
+  const Version *const next = new Version{
+      std::vector<const Page *>(pages.begin(), pages.end()), count,
+      previous->number + 1};
+  retired.push_back({previous, std::move(replaced), 0});
+  replaced.clear();
+  std::fill(published.begin(), published.end(), true);
+  changed = false;
+
+  // Readers that start in the new epoch are sure to see the new version.
+  current.store(next, std::memory_order_seq_cst);
+  retired.back().epoch = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+  reclaim();
+  return next->number;
+}
+
+template <typename ScalarSet>
+std::size_t PublishedPopulation<ScalarSet>::reclaim() noexcept {
+  std::uint64_t oldest = cIdle;
+  for (unsigned i = 0; i < numReaders; i++) {
+    oldest = std::min(oldest, readers[i].epoch.load(std::memory_order_seq_cst));
+  }
+
+  // Versions are retired in epoch order, so those done with are at the front.
+  std::size_t done = 0;
+  while (done < retired.size() && retired[done].epoch <= oldest) {
+    for (const Page *page : retired[done].pages) {
+      delete page;
+    }
+    delete retired[done].version;
+    done++;
+  }
+  retired.erase(retired.begin(), retired.begin() + done);
+
+  return retired.size();
+}
+
+template <typename ScalarSet>
+typename PublishedPopulation<ScalarSet>::View
+PublishedPopulation<ScalarSet>::read(ReaderSlot *slot) const noexcept {
+  // The epoch is marked before the version is loaded, so the writer either
+  // sees the mark, or publishes before the load and so isn't freeing what it
+  // loads.
+  slot->epoch.store(epoch.load(std::memory_order_seq_cst),
+                    std::memory_order_seq_cst);
+  return View(slot, current.load(std::memory_order_seq_cst));
+}
+
+} // namespace stec
+
+#endif // STEC_PUBLISHED_POPULATION_HPP
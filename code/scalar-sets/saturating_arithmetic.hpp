@@ -0,0 +1,405 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SATURATING_ARITHMETIC_HPP
+#define STEC_SATURATING_ARITHMETIC_HPP
+
+#include "scalar_set.hpp"
+#include "swar.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace stec {
+
+namespace detail {
+
+/// \brief Converts the value to T, clamping it to the range of T first, with
+/// a NaN becoming 0. Floating-point values are truncated, as with a cast.
+template <typename T, typename Wide>
+constexpr T saturateTo(const Wide value) noexcept {
+  if constexpr (std::is_floating_point<Wide>::value) {
+    if (value != value) {
+      return 0;
+    }
+  }
+  if (value <= static_cast<Wide>(std::numeric_limits<T>::min())) {
+    return std::numeric_limits<T>::min();
+  }
+  if (value >= static_cast<Wide>(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  }
+  return static_cast<T>(value);
+}
+
+/// \brief Widens an integer to 64 bits for adding to or dividing a value of up
+/// to 32 bits, clamping it to +/-2^33, which gives the same saturated results.
+template <typename Y>
+constexpr std::int64_t saturatingWiden(const Y value) noexcept {
+  constexpr std::int64_t cLimit = static_cast<std::int64_t>(1) << 33;
+  if constexpr (sizeof(Y) < sizeof(std::int64_t)) {
+    return value;
+  } else if constexpr (std::is_signed<Y>::value) {
+    return value < -cLimit ? -cLimit : value > cLimit ? cLimit : value;
+  } else {
+    return value > static_cast<Y>(cLimit) ? cLimit
+                                          : static_cast<std::int64_t>(value);
+  }
+}
+
+template <typename T, typename Y>
+constexpr T saturatingAdd(const T lhs, const Y rhs) noexcept {
+  if constexpr (std::is_floating_point<Y>::value) {
+    // Fused clamp-on-convert, done in the same precision as the built-in +=.
+    return saturateTo<T>(static_cast<Y>(lhs) + rhs);
+  } else {
+    return saturateTo<T>(static_cast<std::int64_t>(lhs) +
+                         saturatingWiden(rhs));
+  }
+}
+
+template <typename T, typename Y>
+constexpr T saturatingSubtract(const T lhs, const Y rhs) noexcept {
+  if constexpr (std::is_floating_point<Y>::value) {
+    return saturateTo<T>(static_cast<Y>(lhs) - rhs);
+  } else {
+    return saturateTo<T>(static_cast<std::int64_t>(lhs) -
+                         saturatingWiden(rhs));
+  }
+}
+
+template <typename T, typename Y>
+constexpr T saturatingMultiply(const T lhs, const Y rhs) noexcept {
+  if constexpr (std::is_floating_point<Y>::value) {
+    return saturateTo<T>(static_cast<Y>(lhs) * rhs);
+  } else if constexpr (sizeof(T) + sizeof(Y) <= 6) {
+    // Any product of up to 48 bits fits in 64 bits.
+    return saturateTo<T>(static_cast<std::int64_t>(lhs) *
+                         static_cast<std::int64_t>(rhs));
+  } else {
+    // Past 2^53 a double is no longer exact, but is also well past the range
+    // of T, so still saturates to the right value.
+    return saturateTo<T>(static_cast<double>(lhs) * static_cast<double>(rhs));
+  }
+}
+
+template <typename T, typename Y>
+constexpr T saturatingDivide(const T lhs, const Y rhs) noexcept {
+  if constexpr (std::is_floating_point<Y>::value) {
+    return saturateTo<T>(static_cast<Y>(lhs) / rhs);
+  } else {
+    // Widening also handles the minimum value divided by -1.
+    return saturateTo<T>(static_cast<std::int64_t>(lhs) /
+                         saturatingWiden(rhs));
+  }
+}
+
+#ifdef __SSE2__
+/// \brief Whether the SSE2 saturating instructions exist for the type.
+template <typename T>
+constexpr bool cHasSaturatingSimd =
+    std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+    (sizeof(T) == 1 || sizeof(T) == 2);
+
+template <typename T>
+inline __m128i saturatingAddSimd(const __m128i lhs,
+                                 const __m128i rhs) noexcept {
+  if constexpr (sizeof(T) == 1) {
+    return std::is_signed<T>::value ? _mm_adds_epi8(lhs, rhs)
+                                    : _mm_adds_epu8(lhs, rhs);
+  } else {
+    return std::is_signed<T>::value ? _mm_adds_epi16(lhs, rhs)
+                                    : _mm_adds_epu16(lhs, rhs);
+  }
+}
+
+template <typename T>
+inline __m128i saturatingSubtractSimd(const __m128i lhs,
+                                      const __m128i rhs) noexcept {
+  if constexpr (sizeof(T) == 1) {
+    return std::is_signed<T>::value ? _mm_subs_epi8(lhs, rhs)
+                                    : _mm_subs_epu8(lhs, rhs);
+  } else {
+    return std::is_signed<T>::value ? _mm_subs_epi16(lhs, rhs)
+                                    : _mm_subs_epu16(lhs, rhs);
+  }
+}
+
+/// \brief Returns the value broadcast to every lane of type T.
+template <typename T>
+inline __m128i broadcastSimd(const T value) noexcept {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_set1_epi8(static_cast<char>(value));
+  } else {
+    return _mm_set1_epi16(static_cast<short>(value));
+  }
+}
+
+/// \brief Multiplies 8 16-bit integers by a finite float, clamping and then
+/// truncating the products back to 16 bits, without leaving the registers.
+template <typename T>
+inline __m128i saturatingMultiplySimd(const __m128i lhs,
+                                      const __m128 rhs) noexcept {
+  __m128 const low = _mm_set1_ps(std::numeric_limits<T>::min());
+  __m128 const high = _mm_set1_ps(std::numeric_limits<T>::max());
+  auto const multiply = [&](__m128i values) {
+    return _mm_cvttps_epi32(_mm_min_ps(
+        _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(values), rhs), low), high));
+  };
+
+  if constexpr (std::is_signed<T>::value) {
+    // Sign-extend each half out to 32 bits.
+    __m128i const lowHalf = _mm_srai_epi32(_mm_unpacklo_epi16(lhs, lhs), 16);
+    __m128i const highHalf = _mm_srai_epi32(_mm_unpackhi_epi16(lhs, lhs), 16);
+    return _mm_packs_epi32(multiply(lowHalf), multiply(highHalf));
+  } else {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const lowHalf = _mm_unpacklo_epi16(lhs, zero);
+    __m128i const highHalf = _mm_unpackhi_epi16(lhs, zero);
+    // SSE2 only has a signed pack, so shift down into the signed range to
+    // pack and then back up again.
+    __m128i const bias = _mm_set1_epi32(0x8000);
+    __m128i const packed =
+        _mm_packs_epi32(_mm_sub_epi32(multiply(lowHalf), bias),
+                        _mm_sub_epi32(multiply(highHalf), bias));
+    return _mm_xor_si128(packed, _mm_set1_epi16(-0x8000));
+  }
+}
+
+inline __m128i loadSimd(const void *values) noexcept {
+  return _mm_loadu_si128(static_cast<const __m128i *>(values));
+}
+
+inline void storeSimd(void *values, const __m128i value) noexcept {
+  _mm_storeu_si128(static_cast<__m128i *>(values), value);
+}
+#endif
+
+} // namespace detail
+
+/// \brief An arithmetic policy for an EnumeratedScalarSet of integers, where
+/// rather than wrapping around, results that overflow are clamped to the
+/// nearest value the type can hold.
+///
+/// Supports integer sets of up to 32 bits, with either integer or
+/// floating-point operands. With a floating-point operand, the result is
+/// clamped before being converted back, so for example an int8_t of 100
+/// multiplied by 1.5f becomes 127, rather than the undefined result of
+/// converting 150.0f to an int8_t. NaN results become 0.
+///
+/// Where SSE2 is available, adding and subtracting sets or scalars of the same
+/// 8 or 16-bit type are done 16 bytes at a time with the saturating
+/// instructions, as is multiplying a 16-bit set by a float.
+struct SaturatingArithmetic {
+  template <typename T, typename Y>
+  static void add(T *lhs, const Y *rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void subtract(T *lhs, const Y *rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void multiply(T *lhs, const Y *rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void divide(T *lhs, const Y *rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void add(T *lhs, const Y rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void subtract(T *lhs, const Y rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void multiply(T *lhs, const Y rhs, int count) noexcept;
+
+  template <typename T, typename Y>
+  static void divide(T *lhs, const Y rhs, int count) noexcept;
+
+  template <typename T>
+  static std::uint64_t addWords(std::uint64_t lhs, std::uint64_t rhs) noexcept {
+    checkType<T>();
+    return detail::swarAddSaturate<T>(lhs, rhs);
+  }
+
+  template <typename T>
+  static std::uint64_t subtractWords(std::uint64_t lhs,
+                                     std::uint64_t rhs) noexcept {
+    checkType<T>();
+    return detail::swarSubtractSaturate<T>(lhs, rhs);
+  }
+
+private:
+  template <typename T>
+  static constexpr void checkType() noexcept {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 4,
+                  "SaturatingArithmetic - The set must be of integers of up "
+                  "to 32 bits.");
+  }
+};
+
+template <typename T, typename Y>
+void SaturatingArithmetic::add(T *lhs, const Y *rhs, int count) noexcept {
+  checkType<T>();
+  int i = 0;
+#ifdef __SSE2__
+  if constexpr (std::is_same<T, Y>::value && detail::cHasSaturatingSimd<T>) {
+    for (; i + 16 / static_cast<int>(sizeof(T)) <= count;
+         i += 16 / static_cast<int>(sizeof(T))) {
+      detail::storeSimd(lhs + i, detail::saturatingAddSimd<T>(
+                                     detail::loadSimd(lhs + i),
+                                     detail::loadSimd(rhs + i)));
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    lhs[i] = detail::saturatingAdd(
+        lhs[i], ScalarSetValueTraits<Y>::toScalar(rhs[i]));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::subtract(T *lhs, const Y *rhs, int count) noexcept {
+  checkType<T>();
+  int i = 0;
+#ifdef __SSE2__
+  if constexpr (std::is_same<T, Y>::value && detail::cHasSaturatingSimd<T>) {
+    for (; i + 16 / static_cast<int>(sizeof(T)) <= count;
+         i += 16 / static_cast<int>(sizeof(T))) {
+      detail::storeSimd(lhs + i, detail::saturatingSubtractSimd<T>(
+                                     detail::loadSimd(lhs + i),
+                                     detail::loadSimd(rhs + i)));
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    lhs[i] = detail::saturatingSubtract(
+        lhs[i], ScalarSetValueTraits<Y>::toScalar(rhs[i]));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::multiply(T *lhs, const Y *rhs, int count) noexcept {
+  checkType<T>();
+  for (int i = 0; i < count; i++) {
+    lhs[i] = detail::saturatingMultiply(
+        lhs[i], ScalarSetValueTraits<Y>::toScalar(rhs[i]));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::divide(T *lhs, const Y *rhs, int count) noexcept {
+  checkType<T>();
+  for (int i = 0; i < count; i++) {
+    lhs[i] = detail::saturatingDivide(
+        lhs[i], ScalarSetValueTraits<Y>::toScalar(rhs[i]));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::add(T *lhs, const Y rhs, int count) noexcept {
+  checkType<T>();
+  int i = 0;
+#ifdef __SSE2__
+  // The scalar can only be broadcast if it fits in T, otherwise clamping it
+  // first would change the result.
+  if constexpr (std::is_integral<Y>::value && detail::cHasSaturatingSimd<T>) {
+    if (detail::saturateTo<T>(detail::saturatingWiden(rhs)) ==
+        detail::saturatingWiden(rhs)) {
+      __m128i const value = detail::broadcastSimd(static_cast<T>(rhs));
+      for (; i + 16 / static_cast<int>(sizeof(T)) <= count;
+           i += 16 / static_cast<int>(sizeof(T))) {
+        detail::storeSimd(lhs + i, detail::saturatingAddSimd<T>(
+                                       detail::loadSimd(lhs + i), value));
+      }
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    lhs[i] = detail::saturatingAdd(lhs[i],
+                                   ScalarSetValueTraits<Y>::toScalar(rhs));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::subtract(T *lhs, const Y rhs, int count) noexcept {
+  checkType<T>();
+  int i = 0;
+#ifdef __SSE2__
+  if constexpr (std::is_integral<Y>::value && detail::cHasSaturatingSimd<T>) {
+    if (detail::saturateTo<T>(detail::saturatingWiden(rhs)) ==
+        detail::saturatingWiden(rhs)) {
+      __m128i const value = detail::broadcastSimd(static_cast<T>(rhs));
+      for (; i + 16 / static_cast<int>(sizeof(T)) <= count;
+           i += 16 / static_cast<int>(sizeof(T))) {
+        detail::storeSimd(lhs + i, detail::saturatingSubtractSimd<T>(
+                                       detail::loadSimd(lhs + i), value));
+      }
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    lhs[i] = detail::saturatingSubtract(lhs[i],
+                                        ScalarSetValueTraits<Y>::toScalar(rhs));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::multiply(T *lhs, const Y rhs, int count) noexcept {
+  checkType<T>();
+  int i = 0;
+#ifdef __SSE2__
+  // A product with NaN or infinity could become NaN, which is left to the
+  // scalar path to turn into 0.
+  if constexpr (std::is_same<Y, float>::value && sizeof(T) == 2) {
+    if (std::isfinite(rhs)) {
+      __m128 const value = _mm_set1_ps(rhs);
+      for (; i + 8 <= count; i += 8) {
+        detail::storeSimd(lhs + i, detail::saturatingMultiplySimd<T>(
+                                       detail::loadSimd(lhs + i), value));
+      }
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    lhs[i] = detail::saturatingMultiply(lhs[i],
+                                        ScalarSetValueTraits<Y>::toScalar(rhs));
+  }
+}
+
+template <typename T, typename Y>
+void SaturatingArithmetic::divide(T *lhs, const Y rhs, int count) noexcept {
+  checkType<T>();
+  for (int i = 0; i < count; i++) {
+    lhs[i] = detail::saturatingDivide(lhs[i],
+                                      ScalarSetValueTraits<Y>::toScalar(rhs));
+  }
+}
+
+/// \brief An EnumeratedScalarSet using SaturatingArithmetic.
+template <typename T, class EnumClass,
+          int NumValues = EnumTraits<EnumClass>::count>
+using SaturatingEnumeratedScalarSet =
+    EnumeratedScalarSet<T, EnumClass, NumValues, SaturatingArithmetic>;
+
+} // namespace stec
+
+#endif // STEC_SATURATING_ARITHMETIC_HPP
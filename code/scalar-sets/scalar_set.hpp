@@ -17,17 +17,179 @@
 #ifndef STEC_ENUMERATED_SCALAR_SET_HPP
 #define STEC_ENUMERATED_SCALAR_SET_HPP
 
+#include "enum_traits.hpp"
+#include "swar.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace stec {
 
+struct WrappingArithmetic;
+
+/// \brief Describes how a type can be used as the values of an
+/// EnumeratedScalarSet.
+/// \tparam T The type of the values.
+///
+/// By default, only scalar types are supported. This can be specialized to
+/// support other arithmetic-like types, with a static constexpr 'isSupported',
+/// the 'Arithmetic' policy sets of the type use by default, and a static
+/// 'toScalar' function, which converts a value to a scalar for sets of
+/// scalars to operate with. Types stored as an integer scaled by a power of
+/// ten also set 'isFixedPoint', the 'raw_type' integer, its 'precision', and
+/// a static 'toRaw' function returning that integer.
+template <typename T>
+struct ScalarSetValueTraits {
+  /// Whether T can be used as the values of an EnumeratedScalarSet.
+  static constexpr bool isSupported = std::is_scalar<T>::value;
+
+  /// The arithmetic policy used by default by sets of T.
+  using Arithmetic = WrappingArithmetic;
+
+  /// Whether values are stored as a raw integer, scaled by 10 to the power of
+  /// the precision.
+  static constexpr bool isFixedPoint = false;
+
+  /// The type each value is stored as.
+  using raw_type = T;
+
+  /// The number of decimal digits stored after the point.
+  static constexpr int precision = 0;
+
+  /// \brief Returns the value as it is stored.
+  static constexpr T toRaw(const T value) noexcept { return value; }
+
+  /// \brief Returns the value as a scalar.
+  static constexpr T toScalar(const T value) noexcept { return value; }
+};
+
+namespace detail {
+
+/// \brief Returns whether a set of the values is small enough to be packed
+/// into one or two 64-bit words, and operated on as lanes of the words.
+template <typename T, int NumValues>
+constexpr bool isPackable() noexcept {
+  return std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+         sizeof(T) * NumValues <= 16;
+}
+
+/// \brief Returns the number of values a set stores, which for packed sets
+/// is padded out to whole 64-bit words.
+template <typename T, int NumValues>
+constexpr int storageSize() noexcept {
+  if constexpr (isPackable<T, NumValues>()) {
+    return static_cast<int>((sizeof(T) * NumValues + 7) / 8 * 8 / sizeof(T));
+  } else {
+    return NumValues;
+  }
+}
+
+/// \brief Whether the arithmetic policy can operate on whole words of lanes
+/// of T, with static addWords and subtractWords functions.
+template <class Arithmetic, typename T, typename = void>
+struct HasWordArithmetic : std::false_type {};
+
+template <class Arithmetic, typename T>
+struct HasWordArithmetic<
+    Arithmetic, T,
+    std::void_t<decltype(Arithmetic::template addWords<T>(0, 0)),
+                decltype(Arithmetic::template subtractWords<T>(0, 0))>>
+    : std::true_type {};
+
+} // namespace detail
+
+/// \brief The default arithmetic for an EnumeratedScalarSet, which does as the
+/// built-in operators do, values wrapping around when they overflow.
+///
+/// An arithmetic policy provides the bulk operations used by the set's
+/// operators, each applied to a whole array of values at once, either with
+/// another array of the same length or a single scalar value.
+///
+/// Policies can also provide addWords and subtractWords, operating on 64-bit
+/// words of lanes of an integer type, which sets small enough to be packed
+/// into words use instead.
+struct WrappingArithmetic {
+  template <typename T, typename Y>
+  static void add(T *lhs, const Y *rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] += ScalarSetValueTraits<Y>::toScalar(rhs[i]);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void subtract(T *lhs, const Y *rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] -= ScalarSetValueTraits<Y>::toScalar(rhs[i]);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void multiply(T *lhs, const Y *rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] *= ScalarSetValueTraits<Y>::toScalar(rhs[i]);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void divide(T *lhs, const Y *rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] /= ScalarSetValueTraits<Y>::toScalar(rhs[i]);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void add(T *lhs, const Y rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] += ScalarSetValueTraits<Y>::toScalar(rhs);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void subtract(T *lhs, const Y rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] -= ScalarSetValueTraits<Y>::toScalar(rhs);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void multiply(T *lhs, const Y rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] *= ScalarSetValueTraits<Y>::toScalar(rhs);
+    }
+  }
+
+  template <typename T, typename Y>
+  static void divide(T *lhs, const Y rhs, int count) noexcept {
+    for (int i = 0; i < count; i++) {
+      lhs[i] /= ScalarSetValueTraits<Y>::toScalar(rhs);
+    }
+  }
+
+  template <typename T>
+  static std::uint64_t addWords(std::uint64_t lhs, std::uint64_t rhs) noexcept {
+    return detail::swarAdd<T>(lhs, rhs);
+  }
+
+  template <typename T>
+  static std::uint64_t subtractWords(std::uint64_t lhs,
+                                     std::uint64_t rhs) noexcept {
+    return detail::swarSubtract<T>(lhs, rhs);
+  }
+};
+
 /// \brief A template for use for tying together a bunch of scalar variables,
-/// performing access with an enum class. \tparam T The underlying type of the
-/// template (ex int, float, etc.) \tparam EnumClass The enum type to use, must
-/// be zero-based and be in a solid incremental block. \tparam NumValues The
-/// number of values held in the template
+/// performing access with an enum class.
+/// \tparam T The underlying type of the template (ex int, float, etc.)
+/// \tparam EnumClass The enum type to use, must be zero-based and be in a solid
+/// incremental block.
+/// \tparam NumValues The number of values held in the template, by default the
+/// number of values in EnumClass, as found by EnumTraits.
+/// \tparam Arithmetic The policy used to carry out the arithmetic operators,
+/// such as WrappingArithmetic or SaturatingArithmetic, by default the one
+/// given by ScalarSetValueTraits.
 ///
 /// The EnumeratedScalarSet is to make stat storage easier, where similar-type
 /// stored scalar values can be stored and accessed either individually or the
@@ -37,13 +199,33 @@ namespace stec {
 ///
 /// This template also takes a parameter for an Enum class, allowing more
 /// restricted/codified access to the elements.
-template <typename T, class EnumClass, int NumValues>
+///
+/// Sets of integers taking up to 16 bytes, such as 7 int8_t values, are
+/// packed into one or two 64-bit words, padded with zeroes. Adding,
+/// subtracting, clamping and comparing them then works on whole words at a
+/// time, each value being a lane of the word, and copying them is a single
+/// move of each word.
+template <typename T, class EnumClass,
+          int NumValues = EnumTraits<EnumClass>::count,
+          class Arithmetic = typename ScalarSetValueTraits<T>::Arithmetic>
 class EnumeratedScalarSet {
-  static_assert(
-      std::is_scalar<T>::value,
-      "EnumeratedScalarSet - Template parameter T must be of scalar type.");
+  static_assert(ScalarSetValueTraits<T>::isSupported,
+                "EnumeratedScalarSet - Template parameter T must be of scalar "
+                "type, or have ScalarSetValueTraits specialized for it.");
 
 public:
+  /// The type of the stored values.
+  using value_type = T;
+
+  /// The enum type used to access the stored values.
+  using enum_type = EnumClass;
+
+  /// The policy used to carry out the arithmetic operators.
+  using arithmetic_type = Arithmetic;
+
+  /// \brief Returns the number of values held in the template.
+  static constexpr int size() noexcept { return NumValues; }
+
   /// \brief Initial value constructor
   /// \param initial This is the value the template vars are set to.
   EnumeratedScalarSet(T initial = 0) noexcept;
@@ -66,9 +248,9 @@ public:
 
   /// \brief Other-typed template copy-constructor.
   /// \param initial The other type to copy-construct over.
-  template <typename Y>
-  EnumeratedScalarSet(
-      EnumeratedScalarSet<Y, EnumClass, NumValues> initial) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet(EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                          initial) noexcept;
 
   /// \brief Returns a reference to the underlying value, denoted by the index.
   /// \return A reference to the value.
@@ -78,69 +260,87 @@ public:
   /// index. \return A const reference to the value.
   T operator[](const EnumClass) const noexcept;
 
-  template <typename Y>
-  bool operator==(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) const
+  /// \brief Returns a pointer to the contiguous array of values, in enum
+  /// order, for operating on all of them at once.
+  T *data() noexcept;
+
+  /// \brief Returns a const pointer to the contiguous array of values, in enum
+  /// order, for operating on all of them at once.
+  const T *data() const noexcept;
+
+  template <typename Y, class YArithmetic>
+  bool operator==(
+      const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &) const
       noexcept;
 
-  template <typename Y>
-  bool operator!=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) const
+  template <typename Y, class YArithmetic>
+  bool operator!=(
+      const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &) const
       noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &
-  operator+=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet &
+  operator+=(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                 &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &
-  operator-=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet &
+  operator-=(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                 &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &
-  operator*=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet &
+  operator*=(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                 &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &
-  operator/=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet &
+  operator/=(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                 &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues>
-  operator+(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet
+  operator+(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues>
-  operator-(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet
+  operator-(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues>
-  operator*(const EnumeratedScalarSet<Y, EnumClass, NumValues> &)noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet
+  operator*(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                &) noexcept;
 
-  template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues>
-  operator/(const EnumeratedScalarSet<Y, EnumClass, NumValues> &) noexcept;
+  template <typename Y, class YArithmetic>
+  EnumeratedScalarSet
+  operator/(const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+                &) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &operator+=(const Y) noexcept;
+  EnumeratedScalarSet &operator+=(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &operator-=(const Y) noexcept;
+  EnumeratedScalarSet &operator-=(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &operator*=(const Y) noexcept;
+  EnumeratedScalarSet &operator*=(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> &operator/=(const Y) noexcept;
+  EnumeratedScalarSet &operator/=(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> operator+(const Y) noexcept;
+  EnumeratedScalarSet operator+(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> operator-(const Y) noexcept;
+  EnumeratedScalarSet operator-(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> operator*(const Y) noexcept;
+  EnumeratedScalarSet operator*(const Y) noexcept;
 
   template <typename Y>
-  EnumeratedScalarSet<T, EnumClass, NumValues> operator/(const Y) noexcept;
+  EnumeratedScalarSet operator/(const Y) noexcept;
 
   /// \brief Clamps the minimum value of the internals to the given parameter.
   /// \param min The value that all values will be clamped to a minimum of.
@@ -151,46 +351,131 @@ public:
   void clampMax(T max) noexcept;
 
 private:
-  /// The actual array of stored stat values.
-  std::array<T, NumValues> stats;
+  /// Whether the values are packed into 64-bit words.
+  static constexpr bool cPacked = detail::isPackable<T, NumValues>();
+
+  /// The number of values stored, including any padding of packed sets.
+  static constexpr int cStorageSize = detail::storageSize<T, NumValues>();
+
+  /// The number of 64-bit words packed sets are made up of.
+  static constexpr int cNumWords = cStorageSize * sizeof(T) / 8;
+
+  /// \brief Returns a word of the packed values.
+  static std::uint64_t loadWord(const T *values, int word) noexcept;
+
+  /// \brief Sets a word of the packed values.
+  void storeWord(int word, std::uint64_t value) noexcept;
+
+  /// \brief Returns the bits of a word of the packed values that aren't
+  /// padding.
+  static constexpr std::uint64_t valueBits(int word) noexcept;
+
+  /// \brief Returns whether the scalar can be used in every lane of the packed
+  /// values, being an integer that keeps its value and sign as a T.
+  template <typename Y>
+  static bool isLaneValue(const Y value) noexcept;
+
+  /// The actual array of stored stat values, along with any padding, which is
+  /// always kept as zero.
+  alignas(cPacked ? 8 : alignof(T)) std::array<T, cStorageSize> stats;
 };
 
-template <typename T, class EnumClass, int NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::EnumeratedScalarSet(
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::EnumeratedScalarSet(
     T initial) noexcept
     : stats{} {
   std::fill_n(stats.data(), NumValues, initial);
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>::EnumeratedScalarSet(
-    EnumeratedScalarSet<Y, EnumClass, NumValues> initial) noexcept
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::EnumeratedScalarSet(
+    EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> initial) noexcept
     : stats{} {
   for (int i = 0; i < NumValues; i++) {
-    stats[i] = initial[static_cast<EnumClass>(i)];
+    stats[i] = static_cast<T>(initial[static_cast<EnumClass>(i)]);
   }
 }
 
-template <typename T, class EnumClass, int NumValues>
-T &EnumeratedScalarSet<T, EnumClass, NumValues>::
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+std::uint64_t
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::loadWord(
+    const T *values, int word) noexcept {
+  std::uint64_t retVal;
+  std::memcpy(&retVal, values + word * (8 / sizeof(T)), 8);
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+void EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::storeWord(
+    int word, std::uint64_t value) noexcept {
+  std::memcpy(stats.data() + word * (8 / sizeof(T)), &value, 8);
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+constexpr std::uint64_t
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::valueBits(
+    int word) noexcept {
+  int const valueBytes = static_cast<int>(sizeof(T) * NumValues) - word * 8;
+  if (valueBytes >= 8) {
+    return ~static_cast<std::uint64_t>(0);
+  }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  // The first values are in the highest lanes.
+  return ~static_cast<std::uint64_t>(0) << ((8 - valueBytes) * 8);
+#else
+  return (static_cast<std::uint64_t>(1) << (valueBytes * 8)) - 1;
+#endif
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y>
+bool EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::isLaneValue(
+    const Y value) noexcept {
+  if constexpr (std::is_integral<Y>::value && !std::is_same<Y, bool>::value) {
+    T const lane = static_cast<T>(value);
+    return static_cast<Y>(lane) == value && (lane < 0) == (value < 0);
+  } else {
+    return false;
+  }
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+T &EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::
 operator[](const EnumClass rhs) noexcept {
   return stats[static_cast<typename std::underlying_type<EnumClass>::type>(
       rhs)];
 }
 
-template <typename T, class EnumClass, int NumValues>
-T EnumeratedScalarSet<T, EnumClass, NumValues>::
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+T EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::
 operator[](const EnumClass rhs) const noexcept {
   return stats[static_cast<typename std::underlying_type<EnumClass>::type>(
       rhs)];
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-bool EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator==(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+T *EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::data() noexcept {
+  return stats.data();
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+const T *
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::data() const
     noexcept {
+  return stats.data();
+}
+
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+bool EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator==(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &rhs) const
+    noexcept {
+  if constexpr (cPacked && std::is_same<T, Y>::value) {
+    // With the padding always zero, the whole words can be compared.
+    return std::memcmp(stats.data(), rhs.data(), sizeof(stats)) == 0;
+  }
+
   for (int i = 0; i < NumValues; i++) {
     if (stats[i] != rhs[static_cast<EnumClass>(i)]) {
       return false;
@@ -200,176 +485,237 @@ operator==(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const
   return true;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-bool EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator!=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+bool EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator!=(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic> &rhs) const
     noexcept {
   return !(*this == rhs);
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator+=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] += rhs[static_cast<EnumClass>(i)];
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator+=(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  if constexpr (cPacked && std::is_same<T, Y>::value &&
+                detail::HasWordArithmetic<Arithmetic, T>::value) {
+    for (int i = 0; i < cNumWords; i++) {
+      storeWord(i, Arithmetic::template addWords<T>(loadWord(stats.data(), i),
+                                                     loadWord(rhs.data(), i)));
+    }
+    return *this;
   }
 
+  Arithmetic::add(stats.data(), rhs.data(), NumValues);
+
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator-=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] -= rhs[static_cast<EnumClass>(i)];
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator-=(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  if constexpr (cPacked && std::is_same<T, Y>::value &&
+                detail::HasWordArithmetic<Arithmetic, T>::value) {
+    for (int i = 0; i < cNumWords; i++) {
+      storeWord(i, Arithmetic::template subtractWords<T>(
+                       loadWord(stats.data(), i), loadWord(rhs.data(), i)));
+    }
+    return *this;
   }
 
+  Arithmetic::subtract(stats.data(), rhs.data(), NumValues);
+
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator*=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] *= rhs[static_cast<EnumClass>(i)];
-  }
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator*=(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  Arithmetic::multiply(stats.data(), rhs.data(), NumValues);
 
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator/=(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] /= rhs[static_cast<EnumClass>(i)];
-  }
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator/=(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  Arithmetic::divide(stats.data(), rhs.data(), NumValues);
 
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator+(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) += rhs;
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator+(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) += rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator-(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) -= rhs;
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator-(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) -= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-    EnumeratedScalarSet<T, EnumClass, NumValues>::operator*(
-        const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) *= rhs;
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator*(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) *= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
-template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::
-operator/(const EnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) /= rhs;
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+template <typename Y, class YArithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator/(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) /= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator+=(const Y rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] += rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator+=(
+    const Y rhs) noexcept {
+  if constexpr (cPacked && detail::HasWordArithmetic<Arithmetic, T>::value) {
+    if (isLaneValue(rhs)) {
+      // The padding lanes are left as zero.
+      std::uint64_t const lanes = detail::swarBroadcast(static_cast<T>(rhs));
+      for (int i = 0; i < cNumWords; i++) {
+        storeWord(i, Arithmetic::template addWords<T>(
+                         loadWord(stats.data(), i), lanes & valueBits(i)));
+      }
+      return *this;
+    }
   }
 
+  Arithmetic::add(stats.data(), rhs, NumValues);
+
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator-=(const Y rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] -= rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator-=(
+    const Y rhs) noexcept {
+  if constexpr (cPacked && detail::HasWordArithmetic<Arithmetic, T>::value) {
+    if (isLaneValue(rhs)) {
+      // The padding lanes are left as zero.
+      std::uint64_t const lanes = detail::swarBroadcast(static_cast<T>(rhs));
+      for (int i = 0; i < cNumWords; i++) {
+        storeWord(i, Arithmetic::template subtractWords<T>(
+                         loadWord(stats.data(), i), lanes & valueBits(i)));
+      }
+      return *this;
+    }
   }
 
+  Arithmetic::subtract(stats.data(), rhs, NumValues);
+
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator*=(const Y rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] *= rhs;
-  }
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator*=(
+    const Y rhs) noexcept {
+  Arithmetic::multiply(stats.data(), rhs, NumValues);
 
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues> &
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator/=(const Y rhs) noexcept {
-  for (int i = 0; i < NumValues; i++) {
-    stats[i] /= rhs;
-  }
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator/=(
+    const Y rhs) noexcept {
+  Arithmetic::divide(stats.data(), rhs, NumValues);
 
   return *this;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator+(const Y rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) += rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator+(
+    const Y rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) += rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator-(const Y rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) -= rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator-(
+    const Y rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) -= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-    EnumeratedScalarSet<T, EnumClass, NumValues>::
-    operator*(const Y rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) *= rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator*(
+    const Y rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) *= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
 template <typename Y>
-EnumeratedScalarSet<T, EnumClass, NumValues>
-EnumeratedScalarSet<T, EnumClass, NumValues>::operator/(const Y rhs) noexcept {
-  return EnumeratedScalarSet<T, EnumClass, NumValues>(*this) /= rhs;
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::operator/(
+    const Y rhs) noexcept {
+  return EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>(*this) /= rhs;
 }
 
-template <typename T, class EnumClass, int NumValues>
-void EnumeratedScalarSet<T, EnumClass, NumValues>::clampMin(T min) noexcept {
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+void EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::clampMin(
+    T min) noexcept {
+  if constexpr (cPacked) {
+    std::uint64_t const lanes = detail::swarBroadcast(min);
+    for (int i = 0; i < cNumWords; i++) {
+      storeWord(i, detail::swarMax<T>(loadWord(stats.data(), i), lanes) &
+                       valueBits(i));
+    }
+    return;
+  }
+
   for (int i = 0; i < NumValues; i++) {
     stats[i] = std::max(stats[i], min);
   }
 }
 
-template <typename T, class EnumClass, int NumValues>
-void EnumeratedScalarSet<T, EnumClass, NumValues>::clampMax(T max) noexcept {
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+void EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>::clampMax(
+    T max) noexcept {
+  if constexpr (cPacked) {
+    std::uint64_t const lanes = detail::swarBroadcast(max);
+    for (int i = 0; i < cNumWords; i++) {
+      storeWord(i, detail::swarMin<T>(loadWord(stats.data(), i), lanes) &
+                       valueBits(i));
+    }
+    return;
+  }
+
   for (int i = 0; i < NumValues; i++) {
     stats[i] = std::min(stats[i], max);
   }
@@ -0,0 +1,326 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_DELTA_HPP
+#define STEC_SCALAR_SET_DELTA_HPP
+
+#include "bit_ops.hpp"
+#include "scalar_set.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace stec {
+
+/// \brief A bit per value of a set, with the bit for value i being bit (i % 64)
+/// of word (i / 64).
+template <int NumValues>
+using ChangeMask = std::array<std::uint64_t, (NumValues + 63) / 64>;
+
+namespace detail {
+
+/// \brief The unsigned integer type of the same size as T, used to compare and
+/// store values by their bit patterns.
+template <typename T>
+using DeltaBits = typename std::conditional<
+    sizeof(T) == 1, std::uint8_t,
+    typename std::conditional<
+        sizeof(T) == 2, std::uint16_t,
+        typename std::conditional<sizeof(T) == 4, std::uint32_t,
+                                  std::uint64_t>::type>::type>::type;
+
+/// \brief Appends the value as a LEB128 varint, 7 bits per byte.
+inline void writeVarint(std::vector<std::uint8_t> &out,
+                        std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+/// \brief Reads a LEB128 varint, returning nullptr if it runs past the end.
+inline const std::uint8_t *readVarint(const std::uint8_t *first,
+                                      const std::uint8_t *last,
+                                      std::uint64_t &value) noexcept {
+  value = 0;
+  for (int shift = 0; first != last && shift < 64; shift += 7) {
+    std::uint8_t const byte = *first++;
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return first;
+    }
+  }
+  return nullptr;
+}
+
+/// \brief Finds which values differ between the two arrays, comparing them by
+/// their bit patterns, 16 values at a time where SSE2 is available.
+template <typename T, int NumValues>
+ChangeMask<NumValues> changedValues(const T *lhs, const T *rhs) noexcept {
+  ChangeMask<NumValues> retVal{};
+  int i = 0;
+
+#ifdef __SSE2__
+  // Each iteration compares 16 values, with the results narrowed down to a
+  // byte each, so that one movemask gives a bit per value. As 16 divides 64,
+  // the bits never straddle two words of the mask.
+  auto load = [](const T *values) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+  };
+  if constexpr (sizeof(T) == 1) {
+    for (; i + 16 <= NumValues; i += 16) {
+      __m128i const equal = _mm_cmpeq_epi8(load(lhs + i), load(rhs + i));
+      retVal[i / 64] |=
+          static_cast<std::uint64_t>(~_mm_movemask_epi8(equal) & 0xffff)
+          << (i % 64);
+    }
+  } else if constexpr (sizeof(T) == 2) {
+    for (; i + 16 <= NumValues; i += 16) {
+      __m128i const equal = _mm_packs_epi16(
+          _mm_cmpeq_epi16(load(lhs + i), load(rhs + i)),
+          _mm_cmpeq_epi16(load(lhs + i + 8), load(rhs + i + 8)));
+      retVal[i / 64] |=
+          static_cast<std::uint64_t>(~_mm_movemask_epi8(equal) & 0xffff)
+          << (i % 64);
+    }
+  } else if constexpr (sizeof(T) == 4) {
+    for (; i + 16 <= NumValues; i += 16) {
+      __m128i const equal = _mm_packs_epi16(
+          _mm_packs_epi32(
+              _mm_cmpeq_epi32(load(lhs + i), load(rhs + i)),
+              _mm_cmpeq_epi32(load(lhs + i + 4), load(rhs + i + 4))),
+          _mm_packs_epi32(
+              _mm_cmpeq_epi32(load(lhs + i + 8), load(rhs + i + 8)),
+              _mm_cmpeq_epi32(load(lhs + i + 12), load(rhs + i + 12))));
+      retVal[i / 64] |=
+          static_cast<std::uint64_t>(~_mm_movemask_epi8(equal) & 0xffff)
+          << (i % 64);
+    }
+  }
+#endif
+
+  for (; i < NumValues; i++) {
+    DeltaBits<T> lhsBits, rhsBits;
+    std::memcpy(&lhsBits, lhs + i, sizeof(T));
+    std::memcpy(&rhsBits, rhs + i, sizeof(T));
+    if (lhsBits != rhsBits) {
+      retVal[i / 64] |= static_cast<std::uint64_t>(1) << (i % 64);
+    }
+  }
+
+  return retVal;
+}
+
+} // namespace detail
+
+/// \brief Returns which values differ between the two sets.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+ChangeMask<NumValues> changedValues(
+    const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &lhs,
+    const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+        &rhs) noexcept {
+  return detail::changedValues<T, NumValues>(lhs.data(), rhs.data());
+}
+
+/// \brief Appends an encoding of the changes needed to turn one set into the
+/// other, that apply() can then use to do so.
+/// \param from The set as it was.
+/// \param to The set as it is now.
+/// \param out The buffer to append the encoded changes to.
+///
+/// The encoding is a bitmask of which values changed, a bit per value rounded
+/// up to whole bytes, followed by each changed value in order. Integer values
+/// are stored as the zigzagged difference as a varint, so small changes take
+/// a single byte. The difference wraps at the width of T, so no change takes
+/// more than a varint of T's width, ie 2 bytes for 8-bit values. Floating-point
+/// values are stored as their new bit pattern.
+///
+/// Encoding two equal sets only takes the bytes of the bitmask.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+void diff(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &from,
+          const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &to,
+          std::vector<std::uint8_t> &out) {
+  static_assert(std::is_arithmetic<T>::value,
+                "diff - Template parameter T must be of arithmetic type.");
+
+  ChangeMask<NumValues> const mask = changedValues(from, to);
+
+  constexpr int cMaskBytes = (NumValues + 7) / 8;
+  for (int i = 0; i < cMaskBytes; i++) {
+    out.push_back(static_cast<std::uint8_t>(mask[i / 8] >> (i % 8 * 8)));
+  }
+
+  detail::forEachSetBit(
+      mask.data(), static_cast<int>(mask.size()), [&](int i) {
+        if constexpr (std::is_floating_point<T>::value) {
+          std::uint8_t bytes[sizeof(T)];
+          std::memcpy(bytes, to.data() + i, sizeof(T));
+          out.insert(out.end(), bytes, bytes + sizeof(T));
+        } else {
+          // The difference wrapped to the width of T, then sign-extended out
+          // to 64 bits, so that wrapping around is a small change.
+          using Bits = detail::DeltaBits<T>;
+          auto const difference = static_cast<std::int64_t>(
+              static_cast<typename std::make_signed<Bits>::type>(
+                  static_cast<Bits>(static_cast<Bits>(to.data()[i]) -
+                                    static_cast<Bits>(from.data()[i]))));
+          detail::writeVarint(out,
+                              (static_cast<std::uint64_t>(difference) << 1) ^
+                                  static_cast<std::uint64_t>(difference >> 63));
+        }
+      });
+}
+
+/// \brief Applies an encoding of changes from diff() to the set.
+/// \param base The set the changes were encoded from, which is modified.
+/// \param first The start of the encoded changes.
+/// \param last One-past the end of the buffer holding the encoded changes.
+/// \return One-past the end of the encoded changes, or nullptr if the
+/// encoding was cut short, in which case the set may be partially modified.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+const std::uint8_t *
+apply(EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &base,
+      const std::uint8_t *first, const std::uint8_t *last) noexcept {
+  constexpr int cMaskBytes = (NumValues + 7) / 8;
+  if (last - first < cMaskBytes) {
+    return nullptr;
+  }
+
+  ChangeMask<NumValues> mask{};
+  for (int i = 0; i < cMaskBytes; i++) {
+    mask[i / 8] |= static_cast<std::uint64_t>(*first++) << (i % 8 * 8);
+  }
+  // Ignore any bits past the last value.
+  if constexpr (NumValues % 64 != 0) {
+    mask.back() &= (static_cast<std::uint64_t>(1) << (NumValues % 64)) - 1;
+  }
+
+  detail::forEachSetBit(
+      mask.data(), static_cast<int>(mask.size()), [&](int i) {
+        if (first == nullptr) {
+          return;
+        }
+        if constexpr (std::is_floating_point<T>::value) {
+          if (last - first < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            first = nullptr;
+            return;
+          }
+          std::memcpy(base.data() + i, first, sizeof(T));
+          first += sizeof(T);
+        } else {
+          std::uint64_t zigzag;
+          first = detail::readVarint(first, last, zigzag);
+          if (first != nullptr) {
+            std::uint64_t const difference =
+                (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+            // Wraps back around at the width of T, as the difference did.
+            base.data()[i] = static_cast<T>(
+                static_cast<std::uint64_t>(base.data()[i]) + difference);
+          }
+        }
+      });
+
+  return first;
+}
+
+/// \brief Appends an encoding of the changes needed to turn one population of
+/// sets into the other.
+/// \param from The first of the sets as they were.
+/// \param to The first of the sets as they are now.
+/// \param count The number of sets in each population.
+/// \param out The buffer to append the encoded changes to.
+///
+/// Only the sets that have changed are encoded, each preceded by a varint of
+/// one more than how many unchanged sets were skipped to get to it. A zero in
+/// place of that varint marks the rest of the population as unchanged, so a
+/// population where nothing has changed is encoded as a single byte.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+void diff(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *from,
+          const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *to,
+          std::size_t count, std::vector<std::uint8_t> &out) {
+  std::size_t skipped = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    ChangeMask<NumValues> const mask = changedValues(from[i], to[i]);
+
+    bool changed = false;
+    for (std::uint64_t const word : mask) {
+      changed |= word != 0;
+    }
+    if (!changed) {
+      skipped++;
+      continue;
+    }
+
+    detail::writeVarint(out, skipped + 1);
+    diff(from[i], to[i], out);
+    skipped = 0;
+  }
+  if (skipped != 0) {
+    detail::writeVarint(out, 0);
+  }
+}
+
+/// \brief Applies an encoding of changes to a population from diff() to the
+/// population.
+/// \param base The first of the sets the changes were encoded from, which are
+/// modified.
+/// \param count The number of sets in the population.
+/// \param first The start of the encoded changes.
+/// \param last One-past the end of the buffer holding the encoded changes.
+/// \return One-past the end of the encoded changes, or nullptr if the
+/// encoding was cut short or doesn't fit the population.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+const std::uint8_t *
+apply(EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *base,
+      std::size_t count, const std::uint8_t *first,
+      const std::uint8_t *last) noexcept {
+  std::size_t i = 0;
+  while (i < count) {
+    std::uint64_t skipped;
+    first = detail::readVarint(first, last, skipped);
+    if (first == nullptr) {
+      return nullptr;
+    }
+    if (skipped == 0) {
+      break;
+    }
+    if (--skipped >= count - i) {
+      return nullptr;
+    }
+    i += static_cast<std::size_t>(skipped);
+
+    first = apply(base[i], first, last);
+    if (first == nullptr) {
+      return nullptr;
+    }
+    i++;
+  }
+
+  return first;
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_DELTA_HPP
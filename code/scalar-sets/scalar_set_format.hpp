@@ -0,0 +1,187 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_FORMAT_HPP
+#define STEC_SCALAR_SET_FORMAT_HPP
+
+#include "enum_traits.hpp"
+#include "scalar_set.hpp"
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+namespace stec {
+
+namespace detail {
+
+/// \brief Returns the most characters valueToChars can write for a value of
+/// the given type.
+template <typename T>
+constexpr std::size_t maxCharsLength() noexcept {
+  using ValueTraits = ScalarSetValueTraits<T>;
+  if constexpr (ValueTraits::isFixedPoint) {
+    // Sign, digits, with at least one before the point, and the point.
+    constexpr std::size_t cDigits =
+        std::numeric_limits<typename ValueTraits::raw_type>::digits10 + 1;
+    constexpr std::size_t cMinDigits = ValueTraits::precision + 1;
+    return 1 + (cDigits > cMinDigits ? cDigits : cMinDigits) +
+           (ValueTraits::precision > 0 ? 1 : 0);
+  } else if constexpr (std::is_floating_point<T>::value) {
+    // Sign, digits, decimal point, and an exponent of 'e-308'.
+    return std::numeric_limits<T>::max_digits10 + 7;
+  } else {
+    // Sign and digits.
+    return std::numeric_limits<T>::digits10 + 2;
+  }
+}
+
+/// \brief Writes the raw value of a FixedPoint with the decimal point put
+/// back in, ie a raw value of -5 with a precision of 2 as '-0.05'.
+template <int Precision, typename Raw>
+std::to_chars_result fixedPointToChars(char *first, char *last,
+                                       const Raw raw) noexcept {
+  using Unsigned = typename std::make_unsigned<Raw>::type;
+  bool negative = false;
+  auto magnitude = static_cast<Unsigned>(raw);
+  if constexpr (std::is_signed<Raw>::value) {
+    if (raw < 0) {
+      negative = true;
+      magnitude = static_cast<Unsigned>(Unsigned{0} - magnitude);
+    }
+  }
+
+  char digits[std::numeric_limits<Unsigned>::digits10 + 1];
+  // Promoted so that char types are written as numbers.
+  char *const digitsEnd =
+      std::to_chars(digits, digits + sizeof(digits), +magnitude).ptr;
+  auto const numDigits = static_cast<std::size_t>(digitsEnd - digits);
+  std::size_t const numWhole =
+      numDigits > Precision ? numDigits - Precision : 0;
+
+  std::size_t const length = (negative ? 1 : 0) +
+                             (numWhole > 0 ? numWhole : 1) +
+                             (Precision > 0 ? 1 + Precision : 0);
+  if (static_cast<std::size_t>(last - first) < length) {
+    return {last, std::errc::value_too_large};
+  }
+
+  if (negative) {
+    *first++ = '-';
+  }
+  if (numWhole == 0) {
+    *first++ = '0';
+  }
+  std::memcpy(first, digits, numWhole);
+  first += numWhole;
+  if constexpr (Precision > 0) {
+    *first++ = '.';
+    std::size_t const numZeros = Precision - (numDigits - numWhole);
+    std::memset(first, '0', numZeros);
+    first += numZeros;
+    std::memcpy(first, digits + numWhole, numDigits - numWhole);
+    first += numDigits - numWhole;
+  }
+
+  return {first, std::errc{}};
+}
+
+/// \brief Writes the value with std::to_chars, or for FixedPoint values, as
+/// the raw value with the decimal point put back in.
+template <typename T>
+std::to_chars_result valueToChars(char *first, char *last,
+                                  const T value) noexcept {
+  using ValueTraits = ScalarSetValueTraits<T>;
+  if constexpr (ValueTraits::isFixedPoint) {
+    return fixedPointToChars<ValueTraits::precision>(
+        first, last, ValueTraits::toRaw(value));
+  } else {
+    // Single-byte types are promoted so that char types print as numbers.
+    return std::to_chars(first, last, +value);
+  }
+}
+
+} // namespace detail
+
+/// \brief Returns the largest number of characters that formatTo can write
+/// for the given type of EnumeratedScalarSet.
+///
+/// As this is a constant expression, it can be used to size a buffer on the
+/// stack, which will always be large enough.
+template <typename ScalarSet>
+constexpr std::size_t formattedSizeMax() noexcept {
+  using Traits = EnumTraits<typename ScalarSet::enum_type>;
+  static_assert(ScalarSet::size() <= Traits::count,
+                "formattedSizeMax - The set has more values than the enum "
+                "has names.");
+
+  std::size_t retVal = 0;
+  for (int i = 0; i < ScalarSet::size(); i++) {
+    // 'Name Value\n'
+    retVal += Traits::names[i].size() + 2 +
+              detail::maxCharsLength<typename ScalarSet::value_type>();
+  }
+
+  return retVal;
+}
+
+/// \brief Writes each of the values of the set, one per line, preceded by the
+/// name of the value, ie 'Strength 6'.
+/// \param first The start of the buffer to write into.
+/// \param last One-past the end of the buffer to write into.
+/// \param set The set of values to write.
+/// \return On success, ptr is one-past the last character written and ec is
+/// value-initialized. If the buffer is too small, ptr is last and ec is
+/// std::errc::value_too_large, with the contents of the buffer unspecified.
+///
+/// Nothing is allocated, and nothing is null-terminated. If the buffer is at
+/// least formattedSizeMax() long, this never fails.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+std::to_chars_result
+formatTo(char *first, char *last,
+         const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+             &set) noexcept {
+  using Traits = EnumTraits<EnumClass>;
+  static_assert(NumValues <= Traits::count,
+                "formatTo - The set has more values than the enum has names.");
+
+  for (int i = 0; i < NumValues; i++) {
+    std::string_view const name = Traits::names[i];
+    if (static_cast<std::size_t>(last - first) < name.size() + 1) {
+      return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, name.data(), name.size());
+    first += name.size();
+    *first++ = ' ';
+
+    std::to_chars_result result =
+        detail::valueToChars(first, last, set[static_cast<EnumClass>(i)]);
+    if (result.ec != std::errc{} || result.ptr == last) {
+      return {last, std::errc::value_too_large};
+    }
+    first = result.ptr;
+    *first++ = '\n';
+  }
+
+  return {first, std::errc{}};
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_FORMAT_HPP
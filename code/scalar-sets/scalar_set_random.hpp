@@ -0,0 +1,514 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_RANDOM_HPP
+#define STEC_SCALAR_SET_RANDOM_HPP
+
+#include "fixed_point_scalar_set.hpp"
+#include "parallel_for.hpp"
+#include "saturating_arithmetic.hpp"
+#include "scalar_set.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace stec {
+
+namespace detail {
+
+/// The increment of SplitMix64, the golden ratio as a 64-bit fraction.
+constexpr std::uint64_t cGoldenGamma = 0x9e3779b97f4a7c15ull;
+
+/// \brief The SplitMix64 finalizer, which scrambles the bits of the value.
+constexpr std::uint64_t mix64(std::uint64_t value) noexcept {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
+#ifdef __SSE2__
+/// \brief Multiplies each 64-bit lane by a constant, given as its low and high
+/// 32-bit halves in each lane, keeping the low 64 bits of the products.
+///
+/// SSE2 only multiplies 32-bit lanes into 64-bit products, so each lane is put
+/// together from three of those, with the high halves only needed for the
+/// cross terms.
+inline __m128i multiplyLanes(__m128i value, __m128i lowHalf,
+                             __m128i highHalf) noexcept {
+  __m128i const cross =
+      _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32), lowHalf),
+                    _mm_mul_epu32(value, highHalf));
+  return _mm_add_epi64(_mm_mul_epu32(value, lowHalf),
+                       _mm_slli_epi64(cross, 32));
+}
+
+/// \brief mix64 of each of the two 64-bit lanes, with its multipliers split
+/// into halves.
+inline __m128i mix64Lanes(__m128i value) noexcept {
+  value = multiplyLanes(_mm_xor_si128(value, _mm_srli_epi64(value, 30)),
+                        _mm_set1_epi64x(0x1ce4e5b9),
+                        _mm_set1_epi64x(0xbf58476d));
+  value = multiplyLanes(_mm_xor_si128(value, _mm_srli_epi64(value, 27)),
+                        _mm_set1_epi64x(0x133111eb),
+                        _mm_set1_epi64x(0x94d049bb));
+  return _mm_xor_si128(value, _mm_srli_epi64(value, 31));
+}
+#endif
+
+/// \brief Returns the high 64 bits of the 128-bit product.
+inline std::uint64_t multiplyHigh(std::uint64_t lhs,
+                                  std::uint64_t rhs) noexcept {
+#ifdef __SIZEOF_INT128__
+  // An extension, so marked as such to keep pedantic builds quiet.
+  __extension__ typedef unsigned __int128 Wide;
+  return static_cast<std::uint64_t>((static_cast<Wide>(lhs) * rhs) >> 64);
+#else
+  std::uint64_t const lhsLow = lhs & 0xffffffff, lhsHigh = lhs >> 32;
+  std::uint64_t const rhsLow = rhs & 0xffffffff, rhsHigh = rhs >> 32;
+  std::uint64_t const cross = (lhsLow * rhsLow >> 32) +
+                              (lhsHigh * rhsLow & 0xffffffff) +
+                              lhsLow * rhsHigh;
+  return lhsHigh * rhsHigh + (lhsHigh * rhsLow >> 32) + (cross >> 32);
+#endif
+}
+
+/// \brief How the values of T are drawn as integers, T's own for integers,
+/// and the raw values of FixedPoint.
+template <typename T, typename = void>
+struct RandomRaw {
+  using type = T;
+  static constexpr T toRaw(const T value) noexcept { return value; }
+  static constexpr T fromRaw(const T raw) noexcept { return raw; }
+};
+
+template <typename T>
+struct RandomRaw<T, std::enable_if_t<IsFixedPoint<T>::value>> {
+  using type = typename IsFixedPoint<T>::raw_type;
+  static type toRaw(const T value) noexcept { return value.getRaw(); }
+  static T fromRaw(const type raw) noexcept { return T::fromRaw(raw); }
+};
+
+/// \brief Draws an offset into a range exactly uniformly, using Lemire's
+/// multiply-and-reject method on the given bits.
+/// \param bits The random bits to draw with.
+/// \param span The size of the range, less one.
+/// \param rejected Set if the bits fell in the sliver of values that would
+/// make the result uneven, and another draw is needed.
+inline std::uint64_t drawOffset(std::uint64_t bits, std::uint64_t span,
+                                bool &rejected) noexcept {
+  if (span < 0xffffffff) {
+    // Only 32 bits are needed, kept to 32-bit products so it vectorizes.
+    std::uint64_t const range = span + 1;
+    std::uint64_t const product = (bits >> 32) * range;
+    rejected = static_cast<std::uint32_t>(product) <
+               static_cast<std::uint32_t>(-range) % range;
+    return product >> 32;
+  } else if (span != ~static_cast<std::uint64_t>(0)) {
+    std::uint64_t const range = span + 1;
+    rejected = bits * range < (0 - range) % range;
+    return multiplyHigh(bits, range);
+  } else {
+    rejected = false;
+    return bits;
+  }
+}
+
+} // namespace detail
+
+/// \brief A counter-based random number generator, where each value is a
+/// function of the seed, a stream and an index, rather than of the values
+/// before it.
+///
+/// Each value is the SplitMix64 finalizer of a key for the stream plus the
+/// index times the golden ratio, so any value can be worked out on its own,
+/// and filling a range of indices is a loop without any dependencies between
+/// iterations. Splitting the work across threads, or in any order, gives the
+/// same values for the same seed.
+///
+/// Integer ranges, including the raw values of FixedPoint, are drawn exactly
+/// uniformly. In the rare case a draw is rejected, the next draw comes from
+/// scrambling the rejected bits again, so is still fixed by the index.
+///
+/// fill() draws ranges of fewer than 2^32 values with SSE2, four at a time,
+/// or leaves the loop for the compiler to vectorize when targeting AVX2 or
+/// later. Wider ranges are drawn one at a time.
+class CounterRandom {
+public:
+  /// \brief Constructor
+  /// \param seed The seed, with different seeds giving unrelated values.
+  explicit constexpr CounterRandom(std::uint64_t seed) noexcept
+      : key(detail::mix64(seed)) {}
+
+  /// \brief Returns 64 random bits for the index of the stream.
+  constexpr std::uint64_t bits(std::uint64_t index,
+                               std::uint64_t stream = 0) const noexcept {
+    return detail::mix64(streamKey(stream) + index * detail::cGoldenGamma);
+  }
+
+  /// \brief Returns an integer or FixedPoint drawn uniformly from
+  /// [lowest, highest].
+  template <typename T>
+  T uniform(std::uint64_t index, std::uint64_t stream, T lowest,
+            T highest) const noexcept;
+
+  /// \brief Returns a double drawn uniformly from [0, 1), with 53 random
+  /// bits.
+  double uniformReal(std::uint64_t index,
+                     std::uint64_t stream = 0) const noexcept {
+    return static_cast<double>(bits(index, stream) >> 11) * 0x1p-53;
+  }
+
+  /// \brief Returns a double drawn from the standard normal distribution.
+  double normal(std::uint64_t index, std::uint64_t stream = 0) const noexcept;
+
+  /// \brief Fills an array of integers or FixedPoint values drawn uniformly
+  /// from [lowest, highest], the value at position i being
+  /// uniform(firstIndex + i, stream, lowest, highest).
+  template <typename T>
+  void fill(T *out, std::size_t count, T lowest, T highest,
+            std::uint64_t firstIndex = 0,
+            std::uint64_t stream = 0) const noexcept;
+
+private:
+  template <typename>
+  friend class SetDistribution;
+
+  constexpr std::uint64_t streamKey(std::uint64_t stream) const noexcept {
+    return detail::mix64(key ^ (stream * detail::cGoldenGamma));
+  }
+
+  /// \brief Draws uniformly from the range of raw values, handing each to
+  /// store(position, raw).
+  template <typename Raw, typename Store>
+  void fillRaw(std::size_t count, Raw lowest, Raw highest,
+               std::uint64_t firstIndex, std::uint64_t stream,
+               Store &&store) const noexcept;
+
+  /// \brief Returns an offset into the range drawn from the bits, drawing
+  /// again until it isn't rejected.
+  static std::uint64_t redraw(std::uint64_t bits, std::uint64_t span) noexcept;
+
+  std::uint64_t key;
+};
+
+/// \brief A distribution for each field of an EnumeratedScalarSet, for drawing
+/// sets from with a CounterRandom.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet.
+///
+/// Every field starts out as the constant 0. Fields can instead be drawn
+/// uniformly, exactly for integers and FixedPoint, or from a normal
+/// distribution, rounded to the nearest value and clamped to the range of
+/// integers and FixedPoint.
+///
+/// Each field of a set is drawn from its own stream, the field's position, at
+/// the set's index, so the set at an index is always the same for the same
+/// seed, however a population is filled.
+template <typename ScalarSet>
+class SetDistribution {
+public:
+  using value_type = typename ScalarSet::value_type;
+  using enum_type = typename ScalarSet::enum_type;
+
+  /// \brief Makes the field always the value.
+  void constant(enum_type field, value_type value) noexcept {
+    fields[toIndex(field)] = {Kind::Constant, value, value, 0, 0};
+  }
+
+  /// \brief Makes the field drawn uniformly from [lowest, highest] for
+  /// integers and FixedPoint, or [lowest, highest) for floating-point values.
+  void uniform(enum_type field, value_type lowest,
+               value_type highest) noexcept {
+    fields[toIndex(field)] = {Kind::Uniform, lowest, highest, 0, 0};
+  }
+
+  /// \brief Makes the field drawn from a normal distribution.
+  void normal(enum_type field, double mean,
+              double standardDeviation) noexcept {
+    fields[toIndex(field)] = {Kind::Normal, value_type(), value_type(), mean,
+                              standardDeviation};
+  }
+
+  /// \brief Returns the set at the index.
+  ScalarSet sample(const CounterRandom &random,
+                   std::uint64_t index) const noexcept;
+
+  /// \brief Fills a population of sets, the set at position i being
+  /// sample(random, firstIndex + i).
+  /// \param random The generator to draw with.
+  /// \param sets The first of the sets.
+  /// \param count The number of sets.
+  /// \param firstIndex The index of the first set.
+  /// \param numThreads The most threads to split the work across, or 0 for one
+  /// per hardware thread.
+  void fill(const CounterRandom &random, ScalarSet *sets, std::size_t count,
+            std::uint64_t firstIndex = 0, unsigned numThreads = 0) const;
+
+private:
+  using Raw = typename detail::RandomRaw<value_type>::type;
+
+  enum class Kind { Constant, Uniform, Normal };
+
+  struct Field {
+    Kind kind;
+    value_type lowest;
+    value_type highest;
+    double mean;
+    double deviation;
+  };
+
+  static int toIndex(enum_type field) noexcept {
+    return static_cast<int>(field);
+  }
+
+  /// \brief Returns the value of the field at the index.
+  static value_type draw(const Field &field, const CounterRandom &random,
+                         std::uint64_t index, int stream) noexcept;
+
+  std::array<Field, ScalarSet::size()> fields{};
+};
+
+template <typename T>
+T CounterRandom::uniform(std::uint64_t index, std::uint64_t stream, T lowest,
+                         T highest) const noexcept {
+  using Raw = typename detail::RandomRaw<T>::type;
+  static_assert(std::is_integral<Raw>::value,
+                "CounterRandom::uniform - T must be an integer or FixedPoint.");
+
+  Raw const lowestRaw = detail::RandomRaw<T>::toRaw(lowest);
+  auto const span = static_cast<std::uint64_t>(
+      static_cast<std::uint64_t>(detail::RandomRaw<T>::toRaw(highest)) -
+      static_cast<std::uint64_t>(lowestRaw));
+  return detail::RandomRaw<T>::fromRaw(static_cast<Raw>(
+      static_cast<std::uint64_t>(lowestRaw) +
+      redraw(bits(index, stream), span)));
+}
+
+inline double CounterRandom::normal(std::uint64_t index,
+                                    std::uint64_t stream) const noexcept {
+  // Box-Muller, with the second uniform from scrambling the first's bits.
+  std::uint64_t const first = bits(index, stream);
+  std::uint64_t const second = detail::mix64(first + detail::cGoldenGamma);
+  double const radius = static_cast<double>((first >> 11) + 1) * 0x1p-53;
+  double const angle = static_cast<double>(second >> 11) * 0x1p-53;
+  return std::sqrt(-2 * std::log(radius)) *
+         std::cos(6.283185307179586 * angle);
+}
+
+template <typename T>
+void CounterRandom::fill(T *out, std::size_t count, T lowest, T highest,
+                         std::uint64_t firstIndex,
+                         std::uint64_t stream) const noexcept {
+  using Raw = typename detail::RandomRaw<T>::type;
+  static_assert(std::is_integral<Raw>::value,
+                "CounterRandom::fill - T must be an integer or FixedPoint.");
+
+  fillRaw(count, detail::RandomRaw<T>::toRaw(lowest),
+          detail::RandomRaw<T>::toRaw(highest), firstIndex, stream,
+          [out](std::size_t i, Raw raw) {
+            out[i] = detail::RandomRaw<T>::fromRaw(raw);
+          });
+}
+
+template <typename Raw, typename Store>
+void CounterRandom::fillRaw(std::size_t count, Raw lowest, Raw highest,
+                            std::uint64_t firstIndex, std::uint64_t stream,
+                            Store &&store) const noexcept {
+  std::uint64_t const base =
+      streamKey(stream) + firstIndex * detail::cGoldenGamma;
+  auto const first = static_cast<std::uint64_t>(lowest);
+  std::uint64_t const span = static_cast<std::uint64_t>(highest) - first;
+
+  // Every position is drawn without branching, with the rare rejected draws
+  // then done again afterwards. Rejections are gathered in an integer, as a
+  // bool would keep the compiler from vectorizing the loops.
+  unsigned anyRejected = 0;
+  if (span < 0xffffffff) {
+    std::uint64_t const range = span + 1;
+    auto const threshold = static_cast<std::uint32_t>(
+        static_cast<std::uint32_t>(-range) % range);
+    std::size_t i = 0;
+#if defined(__SSE2__) && !defined(__AVX2__)
+    // Four positions at a time, as two vectors of two 64-bit lanes. Each
+    // product of the top 32 bits and the range fits in a lane, with the offset
+    // in its high half and the part checked for rejection in its low half.
+    // With AVX2, the compiler vectorizes the plain loop wider than this.
+    auto const lane = [](std::uint64_t value) {
+      return static_cast<long long>(value);
+    };
+    __m128i counters0 = _mm_set_epi64x(lane(base + detail::cGoldenGamma),
+                                       lane(base));
+    __m128i counters1 = _mm_add_epi64(
+        counters0, _mm_set1_epi64x(lane(2 * detail::cGoldenGamma)));
+    __m128i const step = _mm_set1_epi64x(lane(4 * detail::cGoldenGamma));
+    __m128i const ranges = _mm_set1_epi64x(lane(range));
+    // SSE2 only compares signed lanes, so both sides are offset by 2^31.
+    __m128i const bias = _mm_set1_epi32(static_cast<int>(0x80000000));
+    __m128i const thresholds =
+        _mm_xor_si128(_mm_set1_epi32(static_cast<int>(threshold)), bias);
+    __m128i rejections = _mm_setzero_si128();
+    for (std::size_t const end = count - count % 4; i < end; i += 4) {
+      __m128 const products0 = _mm_castsi128_ps(_mm_mul_epu32(
+          _mm_srli_epi64(detail::mix64Lanes(counters0), 32), ranges));
+      __m128 const products1 = _mm_castsi128_ps(_mm_mul_epu32(
+          _mm_srli_epi64(detail::mix64Lanes(counters1), 32), ranges));
+      counters0 = _mm_add_epi64(counters0, step);
+      counters1 = _mm_add_epi64(counters1, step);
+
+      __m128i const lowHalves = _mm_castps_si128(
+          _mm_shuffle_ps(products0, products1, _MM_SHUFFLE(2, 0, 2, 0)));
+      __m128i const highHalves = _mm_castps_si128(
+          _mm_shuffle_ps(products0, products1, _MM_SHUFFLE(3, 1, 3, 1)));
+      rejections = _mm_or_si128(
+          rejections,
+          _mm_cmplt_epi32(_mm_xor_si128(lowHalves, bias), thresholds));
+
+      alignas(16) std::uint32_t offsets[4];
+      _mm_store_si128(reinterpret_cast<__m128i *>(offsets), highHalves);
+      for (int j = 0; j < 4; j++) {
+        store(i + j, static_cast<Raw>(first + offsets[j]));
+      }
+    }
+    anyRejected |= _mm_movemask_epi8(rejections) != 0 ? 1 : 0;
+#endif
+    for (; i < count; i++) {
+      std::uint64_t const product =
+          (detail::mix64(base + i * detail::cGoldenGamma) >> 32) * range;
+      store(i, static_cast<Raw>(first + (product >> 32)));
+      anyRejected |= static_cast<std::uint32_t>(product) < threshold ? 1 : 0;
+    }
+  } else {
+    for (std::size_t i = 0; i < count; i++) {
+      bool rejected;
+      std::uint64_t const offset = detail::drawOffset(
+          detail::mix64(base + i * detail::cGoldenGamma), span, rejected);
+      store(i, static_cast<Raw>(first + offset));
+      anyRejected |= rejected ? 1 : 0;
+    }
+  }
+
+  if (anyRejected != 0) {
+    for (std::size_t i = 0; i < count; i++) {
+      std::uint64_t const bits = detail::mix64(base + i * detail::cGoldenGamma);
+      bool rejected;
+      detail::drawOffset(bits, span, rejected);
+      if (rejected) {
+        store(i, static_cast<Raw>(first + redraw(bits, span)));
+      }
+    }
+  }
+}
+
+inline std::uint64_t CounterRandom::redraw(std::uint64_t bits,
+                                           std::uint64_t span) noexcept {
+  bool rejected;
+  std::uint64_t retVal = detail::drawOffset(bits, span, rejected);
+  while (rejected) {
+    bits = detail::mix64(bits + detail::cGoldenGamma);
+    retVal = detail::drawOffset(bits, span, rejected);
+  }
+  return retVal;
+}
+
+template <typename ScalarSet>
+ScalarSet
+SetDistribution<ScalarSet>::sample(const CounterRandom &random,
+                                   std::uint64_t index) const noexcept {
+  ScalarSet retVal;
+  for (int i = 0; i < ScalarSet::size(); i++) {
+    retVal.data()[i] = draw(fields[i], random, index, i);
+  }
+  return retVal;
+}
+
+template <typename ScalarSet>
+void SetDistribution<ScalarSet>::fill(const CounterRandom &random,
+                                      ScalarSet *sets, std::size_t count,
+                                      std::uint64_t firstIndex,
+                                      unsigned numThreads) const {
+  using Traits = detail::RandomRaw<value_type>;
+
+  numThreads = detail::threadCount(count, numThreads);
+  detail::parallelFor(
+      count, numThreads,
+      [&](unsigned, std::size_t begin, std::size_t end) {
+        // A field at a time, so each is a tight loop over the chunk.
+        for (int i = 0; i < ScalarSet::size(); i++) {
+          const Field &field = fields[i];
+          if constexpr (std::is_integral<Raw>::value) {
+            if (field.kind == Kind::Uniform) {
+              random.fillRaw(end - begin, Traits::toRaw(field.lowest),
+                             Traits::toRaw(field.highest), firstIndex + begin,
+                             static_cast<std::uint64_t>(i),
+                             [&](std::size_t position, Raw raw) {
+                               sets[begin + position].data()[i] =
+                                   Traits::fromRaw(raw);
+                             });
+              continue;
+            }
+          }
+          for (std::size_t set = begin; set < end; set++) {
+            sets[set].data()[i] = draw(field, random, firstIndex + set, i);
+          }
+        }
+      });
+}
+
+template <typename ScalarSet>
+typename SetDistribution<ScalarSet>::value_type
+SetDistribution<ScalarSet>::draw(const Field &field,
+                                 const CounterRandom &random,
+                                 std::uint64_t index, int stream) noexcept {
+  using Traits = detail::RandomRaw<value_type>;
+
+  switch (field.kind) {
+  case Kind::Uniform:
+    if constexpr (std::is_integral<Raw>::value) {
+      return random.uniform(index, static_cast<std::uint64_t>(stream),
+                            field.lowest, field.highest);
+    } else {
+      return static_cast<value_type>(
+          field.lowest + (field.highest - field.lowest) *
+                             random.uniformReal(index, stream));
+    }
+  case Kind::Normal: {
+    double const value =
+        field.mean + field.deviation * random.normal(index, stream);
+    if constexpr (detail::IsFixedPoint<value_type>::value) {
+      return Traits::fromRaw(detail::saturateTo<Raw>(std::round(
+          value * detail::powerOfTen<double>(
+                      detail::IsFixedPoint<value_type>::precision))));
+    } else if constexpr (std::is_integral<Raw>::value) {
+      return detail::saturateTo<Raw>(std::round(value));
+    } else {
+      return static_cast<value_type>(value);
+    }
+  }
+  case Kind::Constant:
+  default:
+    return field.lowest;
+  }
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_RANDOM_HPP
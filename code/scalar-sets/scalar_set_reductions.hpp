@@ -0,0 +1,380 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_REDUCTIONS_HPP
+#define STEC_SCALAR_SET_REDUCTIONS_HPP
+
+#include "parallel_for.hpp"
+#include "scalar_set.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace stec {
+
+/// \brief The type values of T are summed in, wide enough to not overflow
+/// when summing a whole population: 64-bit integers, or double.
+template <typename T>
+using SumType = typename std::conditional<
+    std::is_floating_point<T>::value, double,
+    typename std::conditional<std::is_signed<T>::value, std::int64_t,
+                              std::uint64_t>::type>::type;
+
+namespace detail {
+
+/// The number of independent partial results kept by the reductions, so that
+/// the loops can be vectorized without reordering floating-point operations.
+constexpr int cReductionLanes = 8;
+
+/// \brief Sums the array of values.
+template <typename T>
+SumType<T> sum(const T *values, int count) noexcept {
+  SumType<T> lanes[cReductionLanes] = {};
+  int i = 0;
+
+#ifdef __SSE2__
+  if constexpr (std::is_integral<T>::value && sizeof(T) == 1) {
+    // psadbw sums each 8 unsigned bytes into a 64-bit lane. Signed bytes are
+    // biased up into the unsigned range first, and the bias removed after.
+    __m128i const bias = _mm_set1_epi8(std::is_signed<T>::value ? -0x80 : 0);
+    __m128i total = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+      __m128i const bytes = _mm_xor_si128(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)),
+          bias);
+      total = _mm_add_epi64(total, _mm_sad_epu8(bytes, _mm_setzero_si128()));
+    }
+    std::int64_t halves[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(halves), total);
+    lanes[0] = static_cast<SumType<T>>(
+        halves[0] + halves[1] - (std::is_signed<T>::value ? 128 * i : 0));
+  } else if constexpr (std::is_integral<T>::value && sizeof(T) == 2) {
+    // pmaddwd sums each pair of 16-bit values into a 32-bit lane. Unsigned
+    // values are biased down into the signed range first. A lane grows by at
+    // most 2^16 each step, so is flushed before it could overflow.
+    __m128i const bias =
+        _mm_set1_epi16(std::is_signed<T>::value ? 0 : -0x8000);
+    __m128i const ones = _mm_set1_epi16(1);
+    while (i + 8 <= count) {
+      __m128i total = _mm_setzero_si128();
+      for (int step = 0; step < 32767 && i + 8 <= count; step++, i += 8) {
+        __m128i const words = _mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)),
+            bias);
+        total = _mm_add_epi32(total, _mm_madd_epi16(words, ones));
+      }
+      std::int32_t quarters[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(quarters), total);
+      for (std::int32_t const quarter : quarters) {
+        lanes[0] += static_cast<SumType<T>>(quarter);
+      }
+    }
+    if constexpr (!std::is_signed<T>::value) {
+      lanes[0] += static_cast<SumType<T>>(0x8000) * static_cast<unsigned>(i);
+    }
+  }
+#endif
+
+  for (; i + cReductionLanes <= count; i += cReductionLanes) {
+    for (int lane = 0; lane < cReductionLanes; lane++) {
+      lanes[lane] += static_cast<SumType<T>>(values[i + lane]);
+    }
+  }
+  for (; i < count; i++) {
+    lanes[0] += static_cast<SumType<T>>(values[i]);
+  }
+
+  SumType<T> retVal = 0;
+  for (SumType<T> const lane : lanes) {
+    retVal += lane;
+  }
+  return retVal;
+}
+
+/// \brief Returns the index of the first of the array's smallest or largest
+/// values, as chosen by the comparison.
+template <typename T, typename Compare>
+int extremeIndex(const T *values, int count, Compare compare) noexcept {
+  // Finding the extreme value first and then where it is are both simple
+  // enough to vectorize, unlike tracking the index along the way.
+  T extreme = values[0];
+  for (int i = 1; i < count; i++) {
+    extreme = compare(values[i], extreme) ? values[i] : extreme;
+  }
+  for (int i = 0; i < count; i++) {
+    if (values[i] == extreme) {
+      return i;
+    }
+  }
+  // Only when the extreme value is NaN.
+  return 0;
+}
+
+} // namespace detail
+
+/// \brief Returns the sum of all of the values of the set.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+SumType<T> sum(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+                   &set) noexcept {
+  return detail::sum(set.data(), NumValues);
+}
+
+/// \brief Returns the smallest of the values of the set.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+T minValue(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+               &set) noexcept {
+  return set.data()[detail::extremeIndex(
+      set.data(), NumValues, [](T lhs, T rhs) { return lhs < rhs; })];
+}
+
+/// \brief Returns the largest of the values of the set.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+T maxValue(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+               &set) noexcept {
+  return set.data()[detail::extremeIndex(
+      set.data(), NumValues, [](T lhs, T rhs) { return lhs > rhs; })];
+}
+
+/// \brief Returns the index of the smallest of the values of the set, the
+/// first one if there are several.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumClass argMin(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+                     &set) noexcept {
+  return static_cast<EnumClass>(detail::extremeIndex(
+      set.data(), NumValues, [](T lhs, T rhs) { return lhs < rhs; }));
+}
+
+/// \brief Returns the index of the largest of the values of the set, the
+/// first one if there are several.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumClass argMax(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+                     &set) noexcept {
+  return static_cast<EnumClass>(detail::extremeIndex(
+      set.data(), NumValues, [](T lhs, T rhs) { return lhs > rhs; }));
+}
+
+/// \brief Returns the sum of the products of each of the values of the set
+/// with the matching value of the weights.
+template <typename T, typename Y, class EnumClass, int NumValues,
+          class Arithmetic, class YArithmetic>
+SumType<decltype(T() * Y())>
+dot(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &set,
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, YArithmetic>
+        &weights) noexcept {
+  using Result = SumType<decltype(T() * Y())>;
+
+  Result lanes[detail::cReductionLanes] = {};
+  int i = 0;
+  for (; i + detail::cReductionLanes <= NumValues;
+       i += detail::cReductionLanes) {
+    for (int lane = 0; lane < detail::cReductionLanes; lane++) {
+      lanes[lane] += static_cast<Result>(set.data()[i + lane]) *
+                     static_cast<Result>(weights.data()[i + lane]);
+    }
+  }
+  for (; i < NumValues; i++) {
+    lanes[0] += static_cast<Result>(set.data()[i]) *
+                static_cast<Result>(weights.data()[i]);
+  }
+
+  Result retVal = 0;
+  for (Result const lane : lanes) {
+    retVal += lane;
+  }
+  return retVal;
+}
+
+/// \brief Sums each of the values across a population of sets.
+/// \param sets The first of the sets.
+/// \param count The number of sets.
+/// \param numThreads The most threads to split the work across, or 0 for one
+/// per hardware thread.
+/// \return A set holding the sum of each value.
+///
+/// Each thread sums a contiguous chunk of the population, a whole set at a
+/// time, with the partial sums added together at the end.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumeratedScalarSet<SumType<T>, EnumClass, NumValues>
+columnSums(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *sets,
+           std::size_t count, unsigned numThreads = 0) {
+  using Result = EnumeratedScalarSet<SumType<T>, EnumClass, NumValues>;
+
+  numThreads = detail::threadCount(count, numThreads);
+  std::vector<Result> partials(numThreads);
+  detail::parallelFor(
+      count, numThreads,
+      [&](unsigned thread, std::size_t begin, std::size_t end) {
+        // Summed locally, so threads don't share cache lines as they go.
+        Result totals;
+        for (std::size_t set = begin; set < end; set++) {
+          T const *const values = sets[set].data();
+          for (int i = 0; i < NumValues; i++) {
+            totals.data()[i] += static_cast<SumType<T>>(values[i]);
+          }
+        }
+        partials[thread] = totals;
+      });
+
+  for (unsigned thread = 1; thread < numThreads; thread++) {
+    partials[0] += partials[thread];
+  }
+  return partials[0];
+}
+
+/// \brief Finds the smallest of each of the values across a non-empty
+/// population of sets.
+/// \param sets The first of the sets.
+/// \param count The number of sets, which must not be 0.
+/// \param numThreads The most threads to split the work across, or 0 for one
+/// per hardware thread.
+/// \return A set holding the smallest of each value.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+columnMins(const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *sets,
+           std::size_t count, unsigned numThreads = 0) {
+  using Result = EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>;
+
+  numThreads = detail::threadCount(count, numThreads);
+  std::vector<Result> partials(numThreads);
+  detail::parallelFor(
+      count, numThreads,
+      [&](unsigned thread, std::size_t begin, std::size_t end) {
+        Result mins = sets[0];
+        for (std::size_t set = begin; set < end; set++) {
+          T const *const values = sets[set].data();
+          for (int i = 0; i < NumValues; i++) {
+            mins.data()[i] =
+                values[i] < mins.data()[i] ? values[i] : mins.data()[i];
+          }
+        }
+        partials[thread] = mins;
+      });
+
+  for (unsigned thread = 1; thread < numThreads; thread++) {
+    for (int i = 0; i < NumValues; i++) {
+      partials[0].data()[i] =
+          std::min(partials[0].data()[i], partials[thread].data()[i]);
+    }
+  }
+  return partials[0];
+}
+
+/// \brief Finds the largest of each of the values across a non-empty
+/// population of sets.
+/// \param sets The first of the sets.
+/// \param count The number of sets, which must not be 0.
+/// \param numThreads The most threads to split the work across, or 0 for one
+/// per hardware thread.
+/// \return A set holding the largest of each value.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>
+columnMaxes(
+    const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *sets,
+    std::size_t count, unsigned numThreads = 0) {
+  using Result = EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>;
+
+  numThreads = detail::threadCount(count, numThreads);
+  std::vector<Result> partials(numThreads);
+  detail::parallelFor(
+      count, numThreads,
+      [&](unsigned thread, std::size_t begin, std::size_t end) {
+        Result maxes = sets[0];
+        for (std::size_t set = begin; set < end; set++) {
+          T const *const values = sets[set].data();
+          for (int i = 0; i < NumValues; i++) {
+            maxes.data()[i] =
+                values[i] > maxes.data()[i] ? values[i] : maxes.data()[i];
+          }
+        }
+        partials[thread] = maxes;
+      });
+
+  for (unsigned thread = 1; thread < numThreads; thread++) {
+    for (int i = 0; i < NumValues; i++) {
+      partials[0].data()[i] =
+          std::max(partials[0].data()[i], partials[thread].data()[i]);
+    }
+  }
+  return partials[0];
+}
+
+/// \brief Counts how many sets of a population fall into each of a number of
+/// equal-width buckets, for each value.
+/// \param sets The first of the sets.
+/// \param count The number of sets.
+/// \param lowest The value at the start of the first bucket.
+/// \param highest The value at the end of the last bucket.
+/// \param numBuckets The number of buckets for each value, at least 1.
+/// \param numThreads The most threads to split the work across, or 0 for one
+/// per hardware thread.
+/// \return The counts of each bucket, with value i's buckets starting at
+/// [i * numBuckets]. Values outside of [lowest, highest] are counted in the
+/// first or last bucket, and NaN values are not counted.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+std::vector<std::uint64_t> columnHistograms(
+    const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *sets,
+    std::size_t count, T lowest, T highest, int numBuckets,
+    unsigned numThreads = 0) {
+  std::size_t const numCounts = static_cast<std::size_t>(NumValues) *
+                                static_cast<std::size_t>(numBuckets);
+  double const scale =
+      highest > lowest ? numBuckets / (static_cast<double>(highest) -
+                                       static_cast<double>(lowest))
+                       : 0.;
+
+  numThreads = detail::threadCount(count, numThreads);
+  std::vector<std::vector<std::uint64_t>> partials(
+      numThreads, std::vector<std::uint64_t>(numCounts));
+  detail::parallelFor(
+      count, numThreads,
+      [&](unsigned thread, std::size_t begin, std::size_t end) {
+        std::uint64_t *const counts = partials[thread].data();
+        for (std::size_t set = begin; set < end; set++) {
+          T const *const values = sets[set].data();
+          for (int i = 0; i < NumValues; i++) {
+            double const bucket = std::floor(
+                (static_cast<double>(values[i]) - lowest) * scale);
+            if (bucket != bucket) {
+              continue;
+            }
+            counts[i * numBuckets +
+                   static_cast<int>(std::min(
+                       std::max(bucket, 0.),
+                       static_cast<double>(numBuckets - 1)))]++;
+          }
+        }
+      });
+
+  for (unsigned thread = 1; thread < numThreads; thread++) {
+    for (std::size_t i = 0; i < numCounts; i++) {
+      partials[0][i] += partials[thread][i];
+    }
+  }
+  return std::move(partials[0]);
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_REDUCTIONS_HPP
@@ -0,0 +1,602 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_RING_HPP
+#define STEC_SCALAR_SET_RING_HPP
+
+#include "atomic_scalar_set.hpp"
+#include "enum_traits.hpp"
+#include "scalar_set_snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stec {
+
+/// The current version of the ring layout.
+constexpr std::uint32_t cRingVersion = 2;
+
+/// Identifies the file as a ring, 'STECRING' when read in little-endian.
+constexpr std::uint64_t cRingMagic = 0x474e495243455453ull;
+
+/// \brief The header at the start of every ring file.
+///
+/// The file is laid out as the header, followed by the producer's position
+/// and then each consumer's, each on its own cache line, followed by the
+/// records. Everything is stored in the native byte order.
+struct RingHeader {
+  /// Identifies the file as a ring, only set once the rest of the file has
+  /// been set up.
+  std::atomic<std::uint64_t> magic;
+  /// The version of the layout the ring was created with.
+  std::uint32_t version;
+  /// What kind of value the sets hold, one of the SnapshotValueKind values.
+  std::uint8_t valueKind;
+  /// The size of each individual value, in bytes.
+  std::uint8_t valueSize;
+  /// The number of decimal digits after the point of FixedPoint values, or 0.
+  std::uint8_t precision;
+  std::uint8_t reserved;
+  /// The number of values held in each set.
+  std::uint32_t numValues;
+  /// The size of each record, in bytes, and the distance between them.
+  std::uint32_t recordSize;
+  /// The enumLayoutHash of the enum the ring was created with.
+  std::uint64_t enumHash;
+  /// The number of records the ring holds, a power of two.
+  std::uint64_t capacity;
+  /// The number of consumers, each of which sees every record.
+  std::uint32_t numConsumers;
+  std::uint32_t reserved2;
+  /// The offset from the start of the file to the first record.
+  std::uint64_t dataOffset;
+};
+
+/// \brief A record passed through a ScalarSetRing, of the set of an entity.
+template <typename ScalarSet>
+struct RingRecord {
+  std::uint32_t entity;
+  ScalarSet set;
+};
+
+/// The outcome of creating or opening a ring.
+enum class RingStatus {
+  /// The ring is ready to use.
+  Ok,
+  /// The file could not be created, opened or mapped.
+  OpenFailed,
+  /// The file isn't a ring, or isn't set up yet, or is truncated, or of an
+  /// unknown version.
+  InvalidFile,
+  /// The ring holds a different type of set than this, or was created with a
+  /// different layout of the enum.
+  TypeMismatch,
+  /// The ring was to be created with no capacity, or no consumers.
+  InvalidArgument,
+};
+
+namespace detail {
+
+/// \brief The position of the producer or of a consumer, as the number of
+/// records written or read since the ring was created.
+struct alignas(cCacheLineSize) RingCursor {
+  std::atomic<std::uint64_t> position;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "ScalarSetRing - 64-bit atomics must be lock-free to be shared "
+              "between processes.");
+
+} // namespace detail
+
+/// \brief A ring buffer of records of the sets of entities, in a file mapped
+/// into memory, for one process to stream to others.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet of each record.
+///
+/// One producer writes records, and each of the consumers reads every record,
+/// in order, with the producer only overwriting records once every consumer
+/// has read them. With a single consumer, this is a single-producer,
+/// single-consumer queue. Each side only writes its own position, on its own
+/// cache line, so nothing is locked.
+///
+/// Records are read and written in place, with claim() and publish() on the
+/// producer's side, and peek() and release() on the consumers', so the only
+/// copies are into and out of the ring. push() and pop() copy whole batches
+/// at a time for convenience.
+///
+/// On opening, the type of the values, the number of values, the size of the
+/// records and the layout of the enum are checked against the ring's, so the
+/// two processes always agree on what the records hold. For the lowest
+/// latency, the file should be on a memory-backed file system, such as
+/// /dev/shm.
+///
+/// An instance should only be used as the producer, or as one consumer.
+template <typename ScalarSet>
+class ScalarSetRing {
+  using T = typename ScalarSet::value_type;
+  using EnumClass = typename ScalarSet::enum_type;
+
+public:
+  using Record = RingRecord<ScalarSet>;
+
+  static_assert(std::is_trivially_copyable<Record>::value,
+                "ScalarSetRing - The set must be trivially copyable.");
+
+  /// \brief Default constructor, with no ring opened.
+  ScalarSetRing() noexcept = default;
+
+  /// \brief Destructor, unmapping any opened ring.
+  ~ScalarSetRing() noexcept;
+
+  ScalarSetRing(const ScalarSetRing &) = delete;
+  ScalarSetRing &operator=(const ScalarSetRing &) = delete;
+
+  /// \brief Creates a new ring file and maps it, closing any previously
+  /// opened ring.
+  /// \param path The path of the file to create, which is replaced if it
+  /// exists.
+  /// \param capacity The number of records the ring holds, rounded up to a
+  /// power of two.
+  /// \param numConsumers The number of consumers, each of which must read
+  /// every record before the producer can write over it.
+  /// \return Ok if the ring was created, otherwise why it wasn't. Nothing is
+  /// created for a capacity or number of consumers of 0.
+  RingStatus create(const char *path, std::size_t capacity,
+                    unsigned numConsumers = 1) noexcept;
+
+  /// \brief Opens and maps an existing ring file, closing any previously
+  /// opened ring.
+  /// \param path The path of the file to open.
+  /// \return Ok if the ring is of this type of set, otherwise why it can't be
+  /// used.
+  RingStatus open(const char *path) noexcept;
+
+  /// \brief Unmaps any currently opened ring.
+  void close() noexcept;
+
+  /// \brief Returns the status of the last ring created or opened.
+  RingStatus status() const noexcept { return mStatus; }
+
+  /// \brief Returns the number of records the ring holds.
+  std::size_t capacity() const noexcept {
+    return static_cast<std::size_t>(mMask + 1);
+  }
+
+  /// \brief Returns the number of consumers of the ring.
+  unsigned numConsumers() const noexcept { return mNumConsumers; }
+
+  /// \brief Returns space for the producer to write records to in place.
+  /// \param count The number of records wanted, which is lowered to the
+  /// number of contiguous records free.
+  /// \return The first of the records to write.
+  Record *claim(std::size_t &count) noexcept;
+
+  /// \brief Makes the first count of the claimed records visible to the
+  /// consumers.
+  void publish(std::size_t count) noexcept;
+
+  /// \brief Copies records into the ring, as many as there's space for.
+  /// \return The number of records copied in.
+  std::size_t push(const Record *records, std::size_t count) noexcept;
+
+  /// \brief Copies a single record into the ring.
+  /// \return False if the ring is full.
+  bool push(std::uint32_t entity, const ScalarSet &set) noexcept;
+
+  /// \brief Returns records for the consumer to read in place.
+  /// \param consumer The index of the consumer, less than numConsumers().
+  /// \param count The most records wanted, which is lowered to the number of
+  /// contiguous records ready to read.
+  /// \return The first of the records to read.
+  const Record *peek(unsigned consumer, std::size_t &count) noexcept;
+
+  /// \brief Lets the producer write over the first count of the records
+  /// peeked by the consumer.
+  void release(unsigned consumer, std::size_t count) noexcept;
+
+  /// \brief Copies records out of the ring, as many as are ready up to the
+  /// most given.
+  /// \return The number of records copied out.
+  std::size_t pop(unsigned consumer, Record *out, std::size_t count) noexcept;
+
+private:
+  /// \brief Maps the file, which is already the given size.
+#ifdef _WIN32
+  bool map(HANDLE file, std::size_t size) noexcept;
+#else
+  bool map(int file, std::size_t size) noexcept;
+#endif
+
+  /// \brief Checks the header of the newly mapped file against the set type,
+  /// and finds the positions and records.
+  RingStatus validate() noexcept;
+
+  /// \brief Fills in the layout the ring should have for this type of set.
+  static void describe(RingHeader &header) noexcept;
+
+  RingHeader &header() const noexcept {
+    return *reinterpret_cast<RingHeader *>(mBase);
+  }
+
+  /// The start of the mapped file.
+  unsigned char *mBase = nullptr;
+  /// The size of the mapped file, in bytes.
+  std::size_t mSize = 0;
+  /// The status of the last ring created or opened.
+  RingStatus mStatus = RingStatus::OpenFailed;
+
+  detail::RingCursor *mProducer = nullptr;
+  detail::RingCursor *mConsumers = nullptr;
+  Record *mRecords = nullptr;
+  std::uint64_t mMask = 0;
+  unsigned mNumConsumers = 0;
+  /// What the producer last saw of the slowest consumer's position, or a
+  /// consumer of the producer's, to save reading the other side's cache line
+  /// until it has to.
+  std::uint64_t mCachedPosition = 0;
+};
+
+template <typename ScalarSet>
+ScalarSetRing<ScalarSet>::~ScalarSetRing() noexcept {
+  close();
+}
+
+template <typename ScalarSet>
+RingStatus ScalarSetRing<ScalarSet>::create(const char *path,
+                                            std::size_t capacity,
+                                            unsigned numConsumers) noexcept {
+  close();
+
+  if (capacity == 0 || numConsumers == 0) {
+    return mStatus = RingStatus::InvalidArgument;
+  }
+
+  std::uint64_t roundedCapacity = 1;
+  while (roundedCapacity < capacity) {
+    roundedCapacity <<= 1;
+  }
+  std::uint64_t const dataOffset = detail::snapshotAlign(
+      detail::snapshotAlign(sizeof(RingHeader)) +
+      sizeof(detail::RingCursor) *
+          (1 + static_cast<std::uint64_t>(numConsumers)));
+  auto const size =
+      static_cast<std::size_t>(dataOffset + roundedCapacity * sizeof(Record));
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+  LARGE_INTEGER fileSize;
+  fileSize.QuadPart = static_cast<LONGLONG>(size);
+  bool const mapped = SetFilePointerEx(file, fileSize, nullptr, FILE_BEGIN) &&
+                      SetEndOfFile(file) && map(file, size);
+  CloseHandle(file);
+#else
+  int file = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (file < 0) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+  bool const mapped =
+      ftruncate(file, static_cast<off_t>(size)) == 0 && map(file, size);
+  ::close(file);
+#endif
+  if (!mapped) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+
+  // The file starts out zeroed, so only the header needs filling in.
+  RingHeader &head = header();
+  describe(head);
+  head.capacity = roundedCapacity;
+  head.numConsumers = numConsumers;
+  head.dataOffset = dataOffset;
+  auto *const cursors = reinterpret_cast<detail::RingCursor *>(
+      mBase + detail::snapshotAlign(sizeof(RingHeader)));
+  for (unsigned i = 0; i < 1 + numConsumers; i++) {
+    new (cursors + i) detail::RingCursor{{0}};
+  }
+  // Only marked as a ring once set up, for anything opening it meanwhile.
+  head.magic.store(cRingMagic, std::memory_order_release);
+
+  mStatus = validate();
+  if (mStatus != RingStatus::Ok) {
+    RingStatus const failure = mStatus;
+    close();
+    mStatus = failure;
+  }
+
+  return mStatus;
+}
+
+template <typename ScalarSet>
+RingStatus ScalarSetRing<ScalarSet>::open(const char *path) noexcept {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return mStatus = RingStatus::InvalidFile;
+  }
+  bool const mapped = map(file, static_cast<std::size_t>(fileSize.QuadPart));
+  CloseHandle(file);
+#else
+  int file = ::open(path, O_RDWR);
+  if (file < 0) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+  struct stat fileStat;
+  if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+    ::close(file);
+    return mStatus = RingStatus::InvalidFile;
+  }
+  bool const mapped = map(file, static_cast<std::size_t>(fileStat.st_size));
+  ::close(file);
+#endif
+  if (!mapped) {
+    return mStatus = RingStatus::OpenFailed;
+  }
+
+  mStatus = validate();
+  if (mStatus != RingStatus::Ok) {
+    RingStatus const failure = mStatus;
+    close();
+    mStatus = failure;
+  }
+
+  return mStatus;
+}
+
+template <typename ScalarSet>
+void ScalarSetRing<ScalarSet>::close() noexcept {
+  if (mBase != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(mBase);
+#else
+    munmap(mBase, mSize);
+#endif
+  }
+  mBase = nullptr;
+  mSize = 0;
+  mStatus = RingStatus::OpenFailed;
+  mProducer = nullptr;
+  mConsumers = nullptr;
+  mRecords = nullptr;
+  mMask = 0;
+  mNumConsumers = 0;
+  mCachedPosition = 0;
+}
+
+template <typename ScalarSet>
+typename ScalarSetRing<ScalarSet>::Record *
+ScalarSetRing<ScalarSet>::claim(std::size_t &count) noexcept {
+  std::uint64_t const head =
+      mProducer->position.load(std::memory_order_relaxed);
+  if (head + count - mCachedPosition > mMask + 1) {
+    // Only looks at the consumers when the ring seems too full.
+    mCachedPosition = head;
+    for (unsigned i = 0; i < mNumConsumers; i++) {
+      mCachedPosition = std::min(
+          mCachedPosition,
+          mConsumers[i].position.load(std::memory_order_acquire));
+    }
+  }
+
+  std::uint64_t const free = mMask + 1 - (head - mCachedPosition);
+  std::uint64_t const contiguous = mMask + 1 - (head & mMask);
+  count = static_cast<std::size_t>(
+      std::min<std::uint64_t>({count, free, contiguous}));
+
+  return mRecords + (head & mMask);
+}
+
+template <typename ScalarSet>
+void ScalarSetRing<ScalarSet>::publish(std::size_t count) noexcept {
+  mProducer->position.store(
+      mProducer->position.load(std::memory_order_relaxed) + count,
+      std::memory_order_release);
+}
+
+template <typename ScalarSet>
+std::size_t ScalarSetRing<ScalarSet>::push(const Record *records,
+                                           std::size_t count) noexcept {
+  std::size_t retVal = 0;
+  // At most twice, when the space free wraps around the end of the ring.
+  while (retVal < count) {
+    std::size_t claimed = count - retVal;
+    Record *const to = claim(claimed);
+    if (claimed == 0) {
+      break;
+    }
+    std::copy_n(records + retVal, claimed, to);
+    publish(claimed);
+    retVal += claimed;
+  }
+
+  return retVal;
+}
+
+template <typename ScalarSet>
+bool ScalarSetRing<ScalarSet>::push(std::uint32_t entity,
+                                    const ScalarSet &set) noexcept {
+  std::size_t claimed = 1;
+  Record *const to = claim(claimed);
+  if (claimed == 0) {
+    return false;
+  }
+  to->entity = entity;
+  to->set = set;
+  publish(1);
+
+  return true;
+}
+
+template <typename ScalarSet>
+const typename ScalarSetRing<ScalarSet>::Record *
+ScalarSetRing<ScalarSet>::peek(unsigned consumer, std::size_t &count) noexcept {
+  std::uint64_t const tail =
+      mConsumers[consumer].position.load(std::memory_order_relaxed);
+  // Also reloaded when behind the consumer, as on reopening a ring already
+  // read from.
+  if (mCachedPosition < tail || mCachedPosition - tail < count) {
+    mCachedPosition = mProducer->position.load(std::memory_order_acquire);
+  }
+
+  std::uint64_t const ready = mCachedPosition - tail;
+  std::uint64_t const contiguous = mMask + 1 - (tail & mMask);
+  count = static_cast<std::size_t>(
+      std::min<std::uint64_t>({count, ready, contiguous}));
+
+  return mRecords + (tail & mMask);
+}
+
+template <typename ScalarSet>
+void ScalarSetRing<ScalarSet>::release(unsigned consumer,
+                                       std::size_t count) noexcept {
+  std::atomic<std::uint64_t> &tail = mConsumers[consumer].position;
+  tail.store(tail.load(std::memory_order_relaxed) + count,
+             std::memory_order_release);
+}
+
+template <typename ScalarSet>
+std::size_t ScalarSetRing<ScalarSet>::pop(unsigned consumer, Record *out,
+                                          std::size_t count) noexcept {
+  std::size_t retVal = 0;
+  while (retVal < count) {
+    std::size_t peeked = count - retVal;
+    const Record *const from = peek(consumer, peeked);
+    if (peeked == 0) {
+      break;
+    }
+    std::copy_n(from, peeked, out + retVal);
+    release(consumer, peeked);
+    retVal += peeked;
+  }
+
+  return retVal;
+}
+
+#ifdef _WIN32
+template <typename ScalarSet>
+bool ScalarSetRing<ScalarSet>::map(HANDLE file, std::size_t size) noexcept {
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return false;
+  }
+  void *mapped = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+  // The view keeps the mapping alive on its own.
+  CloseHandle(mapping);
+  if (mapped == nullptr) {
+    return false;
+  }
+#else
+template <typename ScalarSet>
+bool ScalarSetRing<ScalarSet>::map(int file, std::size_t size) noexcept {
+  void *mapped =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+#endif
+  mBase = static_cast<unsigned char *>(mapped);
+  mSize = size;
+
+  return true;
+}
+
+template <typename ScalarSet>
+void ScalarSetRing<ScalarSet>::describe(RingHeader &header) noexcept {
+  header.version = cRingVersion;
+  header.valueKind =
+      static_cast<std::uint8_t>(detail::snapshotValueKind<T>());
+  header.valueSize = sizeof(T);
+  header.precision = detail::snapshotPrecision<T>();
+  header.numValues = ScalarSet::size();
+  header.recordSize = sizeof(Record);
+  header.enumHash = enumLayoutHash<EnumClass>();
+}
+
+template <typename ScalarSet>
+RingStatus ScalarSetRing<ScalarSet>::validate() noexcept {
+  // Make sure everything the header points to is actually in the file.
+  if (mSize < sizeof(RingHeader)) {
+    return RingStatus::InvalidFile;
+  }
+  RingHeader const &head = header();
+  if (head.magic.load(std::memory_order_acquire) != cRingMagic ||
+      head.version != cRingVersion || head.capacity == 0 ||
+      (head.capacity & (head.capacity - 1)) != 0 || head.numConsumers == 0 ||
+      head.dataOffset < detail::snapshotAlign(sizeof(RingHeader)) +
+                            sizeof(detail::RingCursor) *
+                                (1 + static_cast<std::uint64_t>(
+                                         head.numConsumers)) ||
+      head.dataOffset > mSize ||
+      (head.recordSize != 0 &&
+       head.capacity > (mSize - head.dataOffset) / head.recordSize)) {
+    return RingStatus::InvalidFile;
+  }
+
+  RingHeader expected{};
+  describe(expected);
+  if (head.valueKind != expected.valueKind ||
+      head.valueSize != expected.valueSize ||
+      head.precision != expected.precision ||
+      head.numValues != expected.numValues ||
+      head.recordSize != expected.recordSize ||
+      head.enumHash != expected.enumHash) {
+    return RingStatus::TypeMismatch;
+  }
+
+  mProducer = reinterpret_cast<detail::RingCursor *>(
+      mBase + detail::snapshotAlign(sizeof(RingHeader)));
+  mConsumers = mProducer + 1;
+  mRecords = reinterpret_cast<Record *>(mBase + head.dataOffset);
+  mMask = head.capacity - 1;
+  mNumConsumers = head.numConsumers;
+  mCachedPosition = 0;
+
+  return RingStatus::Ok;
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_RING_HPP
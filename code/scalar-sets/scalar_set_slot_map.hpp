@@ -0,0 +1,313 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_SLOT_MAP_HPP
+#define STEC_SCALAR_SET_SLOT_MAP_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace stec {
+
+/// The number of bits of an entity id holding its index within its group,
+/// with the group in the 8 bits above.
+constexpr int cEntityIndexBits = 24;
+
+/// The number of groups entity ids can be in.
+constexpr int cNumEntityGroups = 256;
+
+/// The highest index of an entity within its group.
+constexpr std::uint32_t cMaxEntityIndex = (1u << cEntityIndexBits) - 1;
+
+/// \brief Returns the entity id for the index within the group.
+constexpr std::uint32_t makeEntityId(std::uint8_t group,
+                                     std::uint32_t index) noexcept {
+  return static_cast<std::uint32_t>(group) << cEntityIndexBits |
+         (index & cMaxEntityIndex);
+}
+
+/// \brief Returns the group of the entity id.
+constexpr std::uint8_t entityGroup(std::uint32_t id) noexcept {
+  return static_cast<std::uint8_t>(id >> cEntityIndexBits);
+}
+
+/// \brief Returns the index within its group of the entity id.
+constexpr std::uint32_t entityIndex(std::uint32_t id) noexcept {
+  return id & cMaxEntityIndex;
+}
+
+/// \brief Refers to an entity of a ScalarSetSlotMap. Once the entity has been
+/// erased, the handle no longer refers to anything, even if its id is reused
+/// by another entity.
+struct EntityHandle {
+  /// The id of the entity, packing its group and index.
+  std::uint32_t id;
+  /// The generation of the id's slot when the entity was inserted.
+  std::uint32_t generation;
+
+  bool operator==(const EntityHandle &rhs) const noexcept {
+    return id == rhs.id && generation == rhs.generation;
+  }
+
+  bool operator!=(const EntityHandle &rhs) const noexcept {
+    return !(*this == rhs);
+  }
+};
+
+/// \brief Stores an EnumeratedScalarSet per entity, keyed by entity ids made
+/// up of an 8-bit group and a 24-bit index.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet of each entity.
+///
+/// Each group is its own partition, with a slot for each index, holding the
+/// position of the entity's set in a dense array of the group's sets. Finding
+/// a set is then two array lookups, with the generation of the slot checked
+/// against the handle's, so that stale handles find nothing.
+///
+/// The sets of each group are contiguous, for bulk operations to run over
+/// with sets() and size(), in no particular order, as erasing an entity moves
+/// the group's last set into its place. The slots of erased entities are
+/// reused by later inserts to the group, most recently erased first.
+template <typename ScalarSet>
+class ScalarSetSlotMap {
+public:
+  /// \brief Adds an entity to the group.
+  /// \param group The group to add the entity to.
+  /// \param set The values of the entity.
+  /// \return The handle of the new entity, or nothing if the group already
+  /// holds the most entities it can.
+  std::optional<EntityHandle> insert(std::uint8_t group, const ScalarSet &set);
+
+  /// \brief Removes the entity.
+  /// \return True if the handle referred to an entity, which has been
+  /// removed.
+  bool erase(EntityHandle handle) noexcept;
+
+  /// \brief Returns whether the handle refers to an entity.
+  bool contains(EntityHandle handle) const noexcept {
+    return find(handle) != nullptr;
+  }
+
+  /// \brief Returns the set of the entity, or nullptr if the handle doesn't
+  /// refer to an entity.
+  ScalarSet *find(EntityHandle handle) noexcept;
+
+  /// \brief Returns the set of the entity, or nullptr if the handle doesn't
+  /// refer to an entity.
+  const ScalarSet *find(EntityHandle handle) const noexcept;
+
+  /// \brief Returns the number of entities in all of the groups.
+  std::size_t size() const noexcept { return totalSize; }
+
+  /// \brief Returns the number of entities in the group.
+  std::size_t size(std::uint8_t group) const noexcept {
+    return groups[group].sets.size();
+  }
+
+  /// \brief Returns the contiguous array of the sets of the group.
+  ScalarSet *sets(std::uint8_t group) noexcept {
+    return groups[group].sets.data();
+  }
+
+  /// \brief Returns the contiguous array of the sets of the group.
+  const ScalarSet *sets(std::uint8_t group) const noexcept {
+    return groups[group].sets.data();
+  }
+
+  /// \brief Returns the handles of the entities of the group, in the same
+  /// order as their sets.
+  const EntityHandle *handles(std::uint8_t group) const noexcept {
+    return groups[group].handles.data();
+  }
+
+  /// \brief Calls the function with the handle and a reference to the set of
+  /// every entity, group by group.
+  template <typename Function>
+  void forEach(Function &&function);
+
+  /// \brief Reserves space for the given number of entities in the group.
+  void reserve(std::uint8_t group, std::size_t count);
+
+  /// \brief Removes all of the entities of the group, invalidating their
+  /// handles.
+  void clear(std::uint8_t group) noexcept;
+
+  /// \brief Removes every entity, invalidating their handles.
+  void clear() noexcept;
+
+private:
+  /// Marks the end of a group's list of free slots.
+  static constexpr std::uint32_t cNoSlot = ~static_cast<std::uint32_t>(0);
+
+  struct Slot {
+    /// For a used slot, the position of the entity's set in the dense array.
+    /// For a free slot, the index of the next free slot.
+    std::uint32_t position;
+    /// Odd while the slot is in use, and even while it's free, increasing
+    /// each time the slot is used or freed.
+    std::uint32_t generation;
+  };
+
+  struct Group {
+    std::vector<Slot> slots;
+    std::vector<ScalarSet> sets;
+    /// The handle of the entity of each set.
+    std::vector<EntityHandle> handles;
+    /// The most recently freed slot.
+    std::uint32_t freeSlot = cNoSlot;
+  };
+
+  /// \brief Returns the slot of the handle, or nullptr if the handle doesn't
+  /// refer to an entity.
+  const Slot *findSlot(EntityHandle handle) const noexcept;
+
+  std::array<Group, cNumEntityGroups> groups;
+  std::size_t totalSize = 0;
+};
+
+template <typename ScalarSet>
+std::optional<EntityHandle>
+ScalarSetSlotMap<ScalarSet>::insert(std::uint8_t group, const ScalarSet &set) {
+  Group &target = groups[group];
+
+  std::uint32_t index = target.freeSlot;
+  if (index == cNoSlot) {
+    if (target.slots.size() > cMaxEntityIndex) {
+      return std::nullopt;
+    }
+    index = static_cast<std::uint32_t>(target.slots.size());
+    target.slots.push_back({0, 0});
+  }
+
+  EntityHandle const handle{makeEntityId(group, index),
+                            target.slots[index].generation + 1};
+  target.sets.push_back(set);
+  target.handles.push_back(handle);
+
+  Slot &slot = target.slots[index];
+  if (index == target.freeSlot) {
+    target.freeSlot = slot.position;
+  }
+  slot.position = static_cast<std::uint32_t>(target.sets.size() - 1);
+  slot.generation = handle.generation;
+  totalSize++;
+
+  return handle;
+}
+
+template <typename ScalarSet>
+bool ScalarSetSlotMap<ScalarSet>::erase(EntityHandle handle) noexcept {
+  if (findSlot(handle) == nullptr) {
+    return false;
+  }
+
+  Group &target = groups[entityGroup(handle.id)];
+  Slot &slot = target.slots[entityIndex(handle.id)];
+
+  // Move the last set into the erased one's place.
+  std::uint32_t const last =
+      static_cast<std::uint32_t>(target.sets.size() - 1);
+  if (slot.position != last) {
+    target.sets[slot.position] = target.sets[last];
+    target.handles[slot.position] = target.handles[last];
+    target.slots[entityIndex(target.handles[last].id)].position =
+        slot.position;
+  }
+  target.sets.pop_back();
+  target.handles.pop_back();
+
+  slot.position = target.freeSlot;
+  slot.generation++;
+  target.freeSlot = entityIndex(handle.id);
+  totalSize--;
+
+  return true;
+}
+
+template <typename ScalarSet>
+ScalarSet *ScalarSetSlotMap<ScalarSet>::find(EntityHandle handle) noexcept {
+  const Slot *slot = findSlot(handle);
+  return slot != nullptr ? &groups[entityGroup(handle.id)].sets[slot->position]
+                         : nullptr;
+}
+
+template <typename ScalarSet>
+const ScalarSet *
+ScalarSetSlotMap<ScalarSet>::find(EntityHandle handle) const noexcept {
+  const Slot *slot = findSlot(handle);
+  return slot != nullptr ? &groups[entityGroup(handle.id)].sets[slot->position]
+                         : nullptr;
+}
+
+template <typename ScalarSet>
+template <typename Function>
+void ScalarSetSlotMap<ScalarSet>::forEach(Function &&function) {
+  for (Group &group : groups) {
+    for (std::size_t i = 0; i < group.sets.size(); i++) {
+      function(group.handles[i], group.sets[i]);
+    }
+  }
+}
+
+template <typename ScalarSet>
+void ScalarSetSlotMap<ScalarSet>::reserve(std::uint8_t group,
+                                          std::size_t count) {
+  groups[group].slots.reserve(count);
+  groups[group].sets.reserve(count);
+  groups[group].handles.reserve(count);
+}
+
+template <typename ScalarSet>
+void ScalarSetSlotMap<ScalarSet>::clear(std::uint8_t group) noexcept {
+  Group &target = groups[group];
+  for (EntityHandle const handle : target.handles) {
+    Slot &slot = target.slots[entityIndex(handle.id)];
+    slot.position = target.freeSlot;
+    slot.generation++;
+    target.freeSlot = entityIndex(handle.id);
+  }
+  totalSize -= target.sets.size();
+  target.sets.clear();
+  target.handles.clear();
+}
+
+template <typename ScalarSet>
+void ScalarSetSlotMap<ScalarSet>::clear() noexcept {
+  for (int i = 0; i < cNumEntityGroups; i++) {
+    clear(static_cast<std::uint8_t>(i));
+  }
+}
+
+template <typename ScalarSet>
+const typename ScalarSetSlotMap<ScalarSet>::Slot *
+ScalarSetSlotMap<ScalarSet>::findSlot(EntityHandle handle) const noexcept {
+  const Group &group = groups[entityGroup(handle.id)];
+  std::uint32_t const index = entityIndex(handle.id);
+  if (index >= group.slots.size()) {
+    return nullptr;
+  }
+
+  const Slot &slot = group.slots[index];
+  return (handle.generation & 1) != 0 && slot.generation == handle.generation
+             ? &slot
+             : nullptr;
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_SLOT_MAP_HPP
@@ -0,0 +1,481 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_SNAPSHOT_HPP
+#define STEC_SCALAR_SET_SNAPSHOT_HPP
+
+#include "enum_traits.hpp"
+#include "scalar_set.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stec {
+
+/// The current version of the snapshot file format.
+constexpr std::uint32_t cSnapshotVersion = 2;
+
+/// \brief The header at the start of every snapshot file.
+///
+/// The file is laid out as the header, followed by the names of the enum
+/// values, each null-terminated, followed by the sets themselves, starting on
+/// a 64-byte boundary. Everything is stored in the native byte order, which is
+/// caught by the magic number not matching.
+struct SnapshotHeader {
+  /// Identifies the file as a snapshot, 'STECSNAP'.
+  std::uint64_t magic;
+  /// The version of the format the file was written with.
+  std::uint32_t version;
+  /// What kind of value the sets hold, one of the SnapshotValueKind values.
+  std::uint8_t valueKind;
+  /// The size of each individual value, in bytes.
+  std::uint8_t valueSize;
+  /// The number of decimal digits after the point of FixedPoint values, or 0.
+  std::uint8_t precision;
+  std::uint8_t reserved;
+  /// The number of values held in each set.
+  std::uint32_t numValues;
+  /// The size of each set, in bytes, and the distance between them.
+  std::uint32_t setSize;
+  /// The enumLayoutHash of the enum used to write the file.
+  std::uint64_t enumHash;
+  /// The number of sets in the file.
+  std::uint64_t count;
+  /// The offset from the start of the file to the enum value names.
+  std::uint64_t namesOffset;
+  /// The offset from the start of the file to the first set.
+  std::uint64_t dataOffset;
+};
+
+/// Identifies the file as a snapshot, 'STECSNAP' when read in little-endian.
+constexpr std::uint64_t cSnapshotMagic = 0x50414e5343455453ull;
+
+/// The kinds of value a snapshot can hold.
+enum class SnapshotValueKind : std::uint8_t {
+  SignedInteger,
+  UnsignedInteger,
+  FloatingPoint,
+  /// A FixedPoint with a signed raw value, of the stored precision.
+  SignedFixedPoint,
+  /// A FixedPoint with an unsigned raw value, of the stored precision.
+  UnsignedFixedPoint,
+};
+
+/// The outcome of opening a snapshot.
+enum class SnapshotStatus {
+  /// The file matches the set type exactly, and can be read directly.
+  Ok,
+  /// The file was written with a different layout of the enum, and needs to
+  /// be migrated before use.
+  NeedsMigration,
+  /// The file could not be opened or mapped.
+  OpenFailed,
+  /// The file isn't a snapshot, or is truncated, or of an unknown version.
+  InvalidFile,
+  /// The file holds a different type of value than the set, and can't be
+  /// read.
+  TypeMismatch,
+};
+
+namespace detail {
+
+/// \brief Returns the kind of value T is stored as, going by its
+/// ScalarSetValueTraits for types other than scalars.
+template <typename T>
+constexpr SnapshotValueKind snapshotValueKind() noexcept {
+  using Traits = ScalarSetValueTraits<T>;
+  using Raw = typename Traits::raw_type;
+  if constexpr (Traits::isFixedPoint) {
+    return std::is_signed<Raw>::value ? SnapshotValueKind::SignedFixedPoint
+                                      : SnapshotValueKind::UnsignedFixedPoint;
+  } else {
+    return std::is_floating_point<T>::value ? SnapshotValueKind::FloatingPoint
+           : std::is_signed<T>::value ? SnapshotValueKind::SignedInteger
+                                      : SnapshotValueKind::UnsignedInteger;
+  }
+}
+
+/// \brief Returns the precision stored alongside values of T.
+template <typename T>
+constexpr std::uint8_t snapshotPrecision() noexcept {
+  return static_cast<std::uint8_t>(ScalarSetValueTraits<T>::precision);
+}
+
+/// \brief Rounds the value up to the next multiple of 64.
+constexpr std::uint64_t snapshotAlign(std::uint64_t value) noexcept {
+  return (value + 63) & ~static_cast<std::uint64_t>(63);
+}
+
+} // namespace detail
+
+/// \brief Writes the given sets out to a snapshot file.
+/// \param path The path of the file to write, which is replaced if it exists.
+/// \param sets The first of the sets to write.
+/// \param count The number of sets to write.
+/// \return True if the whole file was written successfully.
+///
+/// The sets are written out as-is in a single block, without any formatting
+/// or conversion.
+template <typename T, class EnumClass, int NumValues, class Arithmetic>
+bool writeSnapshot(
+    const char *path,
+    const EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> *sets,
+    std::size_t count) noexcept {
+  using ScalarSet = EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic>;
+  static_assert(std::is_trivially_copyable<ScalarSet>::value,
+                "writeSnapshot - The set must be trivially copyable.");
+  static_assert(NumValues <= EnumTraits<EnumClass>::count,
+                "writeSnapshot - The set has more values than the enum has "
+                "names.");
+
+  // The names block, each followed by a null.
+  std::vector<char> names;
+  for (int i = 0; i < NumValues; i++) {
+    std::string_view const name = EnumTraits<EnumClass>::names[i];
+    names.insert(names.end(), name.begin(), name.end());
+    names.push_back('\0');
+  }
+
+  SnapshotHeader header{};
+  header.magic = cSnapshotMagic;
+  header.version = cSnapshotVersion;
+  header.valueKind =
+      static_cast<std::uint8_t>(detail::snapshotValueKind<T>());
+  header.valueSize = sizeof(T);
+  header.precision = detail::snapshotPrecision<T>();
+  header.numValues = NumValues;
+  header.setSize = sizeof(ScalarSet);
+  header.enumHash = enumLayoutHash<EnumClass>();
+  header.count = count;
+  header.namesOffset = sizeof(SnapshotHeader);
+  header.dataOffset = detail::snapshotAlign(header.namesOffset + names.size());
+
+  // Pad out to where the data begins.
+  names.resize(header.dataOffset - header.namesOffset, '\0');
+
+  std::FILE *file = std::fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  bool retVal =
+      std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+      std::fwrite(names.data(), 1, names.size(), file) == names.size() &&
+      (count == 0 ||
+       std::fwrite(sets, sizeof(ScalarSet), count, file) == count);
+
+  return std::fclose(file) == 0 && retVal;
+}
+
+/// \brief A read-only view of the sets in a snapshot file, mapped directly
+/// into memory.
+/// \tparam ScalarSet The type of EnumeratedScalarSet held in the file.
+///
+/// When a snapshot is opened that was written with the same type of set as
+/// this, the sets are used right from the mapped file, and nothing is copied
+/// or converted. Only the parts of the file actually read are loaded in from
+/// the disk.
+///
+/// If the file was written with an older or different layout of the enum,
+/// each value is matched back up with a value of the current enum by name, and
+/// the sets copied out through migrate(). Values that no longer exist are
+/// dropped, and new ones are left at 0.
+template <typename ScalarSet>
+class ScalarSetSnapshot {
+  using T = typename ScalarSet::value_type;
+  using EnumClass = typename ScalarSet::enum_type;
+
+  static_assert(std::is_trivially_copyable<ScalarSet>::value,
+                "ScalarSetSnapshot - The set must be trivially copyable.");
+  static_assert(ScalarSet::size() <= EnumTraits<EnumClass>::count,
+                "ScalarSetSnapshot - The set has more values than the enum "
+                "has names.");
+
+public:
+  /// \brief Default constructor, with no file opened.
+  ScalarSetSnapshot() noexcept = default;
+
+  /// \brief Destructor, unmapping any opened file.
+  ~ScalarSetSnapshot() noexcept;
+
+  ScalarSetSnapshot(const ScalarSetSnapshot &) = delete;
+  ScalarSetSnapshot &operator=(const ScalarSetSnapshot &) = delete;
+
+  /// \brief Opens and maps the given snapshot file, closing any previously
+  /// opened file.
+  /// \param path The path of the file to open.
+  /// \return Ok if the sets can be read directly, NeedsMigration if they must
+  /// be copied out with migrate(), otherwise why the file couldn't be used.
+  SnapshotStatus open(const char *path) noexcept;
+
+  /// \brief Unmaps any currently opened file.
+  void close() noexcept;
+
+  /// \brief Returns the status of the last file opened.
+  SnapshotStatus status() const noexcept { return mStatus; }
+
+  /// \brief Returns the first of the sets in the file, or nullptr if the file
+  /// isn't opened with an Ok status.
+  const ScalarSet *data() const noexcept;
+
+  /// \brief Returns the number of sets in the file.
+  std::size_t size() const noexcept;
+
+  const ScalarSet *begin() const noexcept { return data(); }
+  const ScalarSet *end() const noexcept { return data() + size(); }
+
+  /// \brief Returns the set at the given position, which must be less than
+  /// size(), and the file opened with an Ok status.
+  const ScalarSet &operator[](std::size_t index) const noexcept {
+    return data()[index];
+  }
+
+  /// \brief Copies every set out of the file into the given vector, which is
+  /// resized to fit, converting them to the current layout of the enum.
+  /// \return True if the file is opened with an Ok or NeedsMigration status.
+  ///
+  /// Only the layout of the enum is converted. Files holding values of any
+  /// other kind, size or precision are a TypeMismatch, and never migrated.
+  bool migrate(std::vector<ScalarSet> &out) const;
+
+private:
+  /// \brief Checks the header of the newly mapped file against the set type.
+  SnapshotStatus validate() const noexcept;
+
+  /// \brief Returns the header at the start of the mapped file.
+  const SnapshotHeader &header() const noexcept;
+
+  /// The start of the mapped file.
+  const unsigned char *mBase = nullptr;
+  /// The size of the mapped file, in bytes.
+  std::size_t mSize = 0;
+  /// The status of the last file opened.
+  SnapshotStatus mStatus = SnapshotStatus::OpenFailed;
+#ifdef _WIN32
+  /// The handle to the file mapping object.
+  HANDLE mMapping = nullptr;
+#endif
+};
+
+template <typename ScalarSet>
+ScalarSetSnapshot<ScalarSet>::~ScalarSetSnapshot() noexcept {
+  close();
+}
+
+template <typename ScalarSet>
+SnapshotStatus ScalarSetSnapshot<ScalarSet>::open(const char *path) noexcept {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return mStatus = SnapshotStatus::OpenFailed;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return mStatus = SnapshotStatus::InvalidFile;
+  }
+  mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mMapping == nullptr) {
+    return mStatus = SnapshotStatus::OpenFailed;
+  }
+  void *mapped = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+  if (mapped == nullptr) {
+    CloseHandle(mMapping);
+    mMapping = nullptr;
+    return mStatus = SnapshotStatus::OpenFailed;
+  }
+  mSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  int file = ::open(path, O_RDONLY);
+  if (file < 0) {
+    return mStatus = SnapshotStatus::OpenFailed;
+  }
+  struct stat fileStat;
+  if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+    ::close(file);
+    return mStatus = SnapshotStatus::InvalidFile;
+  }
+  void *mapped = mmap(nullptr, static_cast<std::size_t>(fileStat.st_size),
+                      PROT_READ, MAP_SHARED, file, 0);
+  ::close(file);
+  if (mapped == MAP_FAILED) {
+    return mStatus = SnapshotStatus::OpenFailed;
+  }
+  mSize = static_cast<std::size_t>(fileStat.st_size);
+#endif
+  mBase = static_cast<const unsigned char *>(mapped);
+
+  mStatus = validate();
+  if (mStatus != SnapshotStatus::Ok &&
+      mStatus != SnapshotStatus::NeedsMigration) {
+    // Nothing more can be done with the file, so let go of it now.
+    SnapshotStatus const failure = mStatus;
+    close();
+    mStatus = failure;
+  }
+
+  return mStatus;
+}
+
+template <typename ScalarSet>
+SnapshotStatus ScalarSetSnapshot<ScalarSet>::validate() const noexcept {
+  // Make sure everything the header points to is actually in the file.
+  if (mSize < sizeof(SnapshotHeader)) {
+    return SnapshotStatus::InvalidFile;
+  }
+  SnapshotHeader const &head = header();
+  if (head.magic != cSnapshotMagic || head.version != cSnapshotVersion ||
+      head.numValues == 0 || head.setSize == 0 ||
+      head.setSize < static_cast<std::uint64_t>(head.valueSize) *
+                         head.numValues ||
+      head.namesOffset < sizeof(SnapshotHeader) ||
+      head.namesOffset > head.dataOffset || head.dataOffset > mSize ||
+      head.dataOffset % 64 != 0 ||
+      head.count > (mSize - head.dataOffset) / head.setSize) {
+    return SnapshotStatus::InvalidFile;
+  }
+
+  if (head.valueKind !=
+          static_cast<std::uint8_t>(detail::snapshotValueKind<T>()) ||
+      head.valueSize != sizeof(T) ||
+      head.precision != detail::snapshotPrecision<T>()) {
+    return SnapshotStatus::TypeMismatch;
+  }
+
+  if (head.enumHash != enumLayoutHash<EnumClass>() ||
+      head.numValues != static_cast<std::uint32_t>(ScalarSet::size()) ||
+      head.setSize != sizeof(ScalarSet)) {
+    return SnapshotStatus::NeedsMigration;
+  }
+
+  return SnapshotStatus::Ok;
+}
+
+template <typename ScalarSet>
+void ScalarSetSnapshot<ScalarSet>::close() noexcept {
+  if (mBase != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(mBase);
+    CloseHandle(mMapping);
+    mMapping = nullptr;
+#else
+    munmap(const_cast<unsigned char *>(mBase), mSize);
+#endif
+  }
+  mBase = nullptr;
+  mSize = 0;
+  mStatus = SnapshotStatus::OpenFailed;
+}
+
+template <typename ScalarSet>
+const ScalarSet *ScalarSetSnapshot<ScalarSet>::data() const noexcept {
+  if (mStatus != SnapshotStatus::Ok) {
+    return nullptr;
+  }
+  return reinterpret_cast<const ScalarSet *>(mBase + header().dataOffset);
+}
+
+template <typename ScalarSet>
+std::size_t ScalarSetSnapshot<ScalarSet>::size() const noexcept {
+  if (mStatus != SnapshotStatus::Ok &&
+      mStatus != SnapshotStatus::NeedsMigration) {
+    return 0;
+  }
+  return static_cast<std::size_t>(header().count);
+}
+
+template <typename ScalarSet>
+bool ScalarSetSnapshot<ScalarSet>::migrate(std::vector<ScalarSet> &out) const {
+  if (mStatus == SnapshotStatus::Ok) {
+    out.assign(data(), data() + size());
+    return true;
+  }
+  if (mStatus != SnapshotStatus::NeedsMigration) {
+    return false;
+  }
+
+  SnapshotHeader const &head = header();
+
+  // Work out where each of the stored values goes in the current sets, by
+  // matching up their names. The names are only trusted up to the data.
+  std::vector<std::size_t> fromOffsets;
+  std::vector<int> toIndices;
+  const char *name = reinterpret_cast<const char *>(mBase + head.namesOffset);
+  const char *namesEnd =
+      reinterpret_cast<const char *>(mBase + head.dataOffset);
+  for (std::uint32_t column = 0; column < head.numValues; column++) {
+    const char *nameEnd =
+        static_cast<const char *>(std::memchr(name, '\0', namesEnd - name));
+    if (nameEnd == nullptr) {
+      return false;
+    }
+
+    std::string_view const storedName(name, nameEnd - name);
+    for (int i = 0; i < ScalarSet::size(); i++) {
+      if (EnumTraits<EnumClass>::names[i] == storedName) {
+        fromOffsets.push_back(column * sizeof(T));
+        toIndices.push_back(i);
+        break;
+      }
+    }
+    name = nameEnd + 1;
+  }
+
+  // Then remap every set in one pass over the file.
+  out.assign(static_cast<std::size_t>(head.count), ScalarSet{});
+  const unsigned char *from = mBase + head.dataOffset;
+  for (ScalarSet &set : out) {
+    for (std::size_t i = 0; i < toIndices.size(); i++) {
+      T value;
+      std::memcpy(&value, from + fromOffsets[i], sizeof(T));
+      set[static_cast<EnumClass>(toIndices[i])] = value;
+    }
+    from += head.setSize;
+  }
+
+  return true;
+}
+
+template <typename ScalarSet>
+const SnapshotHeader &ScalarSetSnapshot<ScalarSet>::header() const noexcept {
+  return *reinterpret_cast<const SnapshotHeader *>(mBase);
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_SNAPSHOT_HPP
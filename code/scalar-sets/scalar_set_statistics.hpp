@@ -0,0 +1,346 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SCALAR_SET_STATISTICS_HPP
+#define STEC_SCALAR_SET_STATISTICS_HPP
+
+#include "scalar_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace stec {
+
+/// \brief A sketch of a stream of values, that gives any quantile of them to
+/// within a relative error, without storing the values themselves.
+///
+/// Values are counted in buckets whose bounds grow geometrically, so that
+/// every value in a bucket is within the relative error of the bucket's
+/// middle, as in DDSketch. Only the buckets between the smallest and largest
+/// values seen are stored, separately for positive and negative values, with
+/// values closer to zero than cMinMagnitude counted as zero.
+///
+/// Sketches with the same relative error can be merged, giving the same
+/// sketch as if all of the values had been added to one.
+class QuantileSketch {
+public:
+  /// Values closer to zero than this are counted as zero.
+  static constexpr double cMinMagnitude = 1e-9;
+
+  /// \brief Constructor
+  /// \param relativeError The most any quantile is out by, as a fraction of
+  /// its value, such as 0.01 for 1%.
+  explicit QuantileSketch(double relativeError = 0.01) noexcept
+      : gamma((1 + relativeError) / (1 - relativeError)),
+        indexScale(1 / std::log(gamma)) {}
+
+  /// \brief Adds a value, which must be finite.
+  void add(double value);
+
+  /// \brief Adds the values of another sketch, which must have been made with
+  /// the same relative error.
+  void merge(const QuantileSketch &other);
+
+  /// \brief Returns the number of values added.
+  std::uint64_t count() const noexcept {
+    return positive.total + negative.total + zeroCount;
+  }
+
+  /// \brief Returns the value at the quantile of the values added, such as
+  /// 0.99 for the 99th percentile, or NaN if no values have been added.
+  double quantile(double q) const noexcept;
+
+private:
+  /// The counts of a run of buckets, for values of one sign.
+  struct Buckets {
+    std::vector<std::uint64_t> counts;
+    /// The index of the first bucket of the counts.
+    int first = 0;
+    std::uint64_t total = 0;
+
+    void add(int index, std::uint64_t count);
+  };
+
+  /// \brief Returns the bucket of a value, which must be at least
+  /// cMinMagnitude.
+  int bucketOf(double magnitude) const noexcept {
+    return static_cast<int>(std::ceil(std::log(magnitude) * indexScale));
+  }
+
+  /// \brief Returns the middle value of a bucket.
+  double valueOf(int index) const noexcept {
+    return 2 * std::pow(gamma, index) / (1 + gamma);
+  }
+
+  double gamma;
+  double indexScale;
+  Buckets positive;
+  /// Buckets of the magnitudes of negative values.
+  Buckets negative;
+  std::uint64_t zeroCount = 0;
+};
+
+inline void QuantileSketch::Buckets::add(int index, std::uint64_t count) {
+  if (counts.empty()) {
+    first = index;
+    counts.push_back(0);
+  } else if (index < first) {
+    counts.insert(counts.begin(), static_cast<std::size_t>(first - index), 0);
+    first = index;
+  } else if (index - first >= static_cast<int>(counts.size())) {
+    counts.resize(static_cast<std::size_t>(index - first) + 1);
+  }
+  counts[static_cast<std::size_t>(index - first)] += count;
+  total += count;
+}
+
+inline void QuantileSketch::add(double value) {
+  if (value >= cMinMagnitude) {
+    positive.add(bucketOf(value), 1);
+  } else if (value <= -cMinMagnitude) {
+    negative.add(bucketOf(-value), 1);
+  } else {
+    zeroCount++;
+  }
+}
+
+inline void QuantileSketch::merge(const QuantileSketch &other) {
+  for (std::size_t i = 0; i < other.positive.counts.size(); i++) {
+    if (other.positive.counts[i] != 0) {
+      positive.add(other.positive.first + static_cast<int>(i),
+                   other.positive.counts[i]);
+    }
+  }
+  for (std::size_t i = 0; i < other.negative.counts.size(); i++) {
+    if (other.negative.counts[i] != 0) {
+      negative.add(other.negative.first + static_cast<int>(i),
+                   other.negative.counts[i]);
+    }
+  }
+  zeroCount += other.zeroCount;
+}
+
+inline double QuantileSketch::quantile(double q) const noexcept {
+  std::uint64_t const total = count();
+  if (total == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  // The rank of the value wanted, counting from zero.
+  auto const rank = static_cast<std::uint64_t>(
+      std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+
+  // Negative values, from the largest magnitude down.
+  std::uint64_t seen = 0;
+  for (std::size_t i = negative.counts.size(); i-- > 0;) {
+    seen += negative.counts[i];
+    if (seen > rank) {
+      return -valueOf(negative.first + static_cast<int>(i));
+    }
+  }
+
+  seen += zeroCount;
+  if (seen > rank) {
+    return 0;
+  }
+
+  for (std::size_t i = 0; i < positive.counts.size(); i++) {
+    seen += positive.counts[i];
+    if (seen > rank) {
+      return valueOf(positive.first + static_cast<int>(i));
+    }
+  }
+
+  return valueOf(positive.first + static_cast<int>(positive.counts.size()) - 1);
+}
+
+/// \brief Streaming statistics of each field of a stream of
+/// EnumeratedScalarSets, without storing the sets themselves.
+/// \tparam ScalarSet The type of the EnumeratedScalarSet.
+///
+/// The mean and variance of each field are kept with Welford's method, which
+/// stays accurate over long streams, along with the lowest and highest values,
+/// all held as arrays across the fields so each set is taken in with one pass
+/// over its values. Each field also has a QuantileSketch, for percentiles.
+///
+/// To take in a stream across threads, each thread can add to its own
+/// instance, with the instances merged together at the end.
+template <typename ScalarSet>
+class FieldStatistics {
+public:
+  using enum_type = typename ScalarSet::enum_type;
+
+  /// \brief Constructor
+  /// \param relativeError The relative error of the quantiles of each field.
+  explicit FieldStatistics(double relativeError = 0.01);
+
+  /// \brief Adds a set to the statistics.
+  void add(const ScalarSet &set);
+
+  /// \brief Adds a number of sets to the statistics.
+  void add(const ScalarSet *sets, std::size_t count);
+
+  /// \brief Adds the sets taken in by other statistics to these, as though
+  /// they had all been added to these.
+  void merge(const FieldStatistics &other);
+
+  /// \brief Returns the number of sets added.
+  std::uint64_t count() const noexcept { return numSets; }
+
+  /// \brief Returns the mean of the field, or NaN if no sets have been added.
+  double mean(enum_type field) const noexcept {
+    return numSets != 0 ? means[toIndex(field)]
+                        : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /// \brief Returns the variance of the field across all of the sets added,
+  /// or NaN if no sets have been added.
+  double variance(enum_type field) const noexcept {
+    return numSets != 0 ? squares[toIndex(field)] / numSets
+                        : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /// \brief Returns the variance of the field, treating the sets added as a
+  /// sample of a larger population, or NaN if fewer than two have been
+  /// added.
+  double sampleVariance(enum_type field) const noexcept {
+    return numSets > 1 ? squares[toIndex(field)] / (numSets - 1)
+                       : std::numeric_limits<double>::quiet_NaN();
+  }
+
+  /// \brief Returns the standard deviation of the field across all of the
+  /// sets added.
+  double standardDeviation(enum_type field) const noexcept {
+    return std::sqrt(variance(field));
+  }
+
+  /// \brief Returns the lowest value of the field, or infinity if no sets
+  /// have been added.
+  double min(enum_type field) const noexcept { return lowest[toIndex(field)]; }
+
+  /// \brief Returns the highest value of the field, or -infinity if no sets
+  /// have been added.
+  double max(enum_type field) const noexcept {
+    return highest[toIndex(field)];
+  }
+
+  /// \brief Returns the value of the field at the quantile, such as 0.5 for
+  /// the median, or NaN if no sets have been added.
+  double quantile(enum_type field, double q) const noexcept;
+
+private:
+  static constexpr int cNumValues = ScalarSet::size();
+
+  static int toIndex(enum_type field) noexcept {
+    return static_cast<int>(field);
+  }
+
+  std::uint64_t numSets = 0;
+  std::array<double, cNumValues> means{};
+  /// The sums of the squared differences from the mean.
+  std::array<double, cNumValues> squares{};
+  std::array<double, cNumValues> lowest;
+  std::array<double, cNumValues> highest;
+  std::vector<QuantileSketch> sketches;
+};
+
+template <typename ScalarSet>
+FieldStatistics<ScalarSet>::FieldStatistics(double relativeError)
+    : sketches(cNumValues, QuantileSketch(relativeError)) {
+  lowest.fill(std::numeric_limits<double>::infinity());
+  highest.fill(-std::numeric_limits<double>::infinity());
+}
+
+template <typename ScalarSet>
+void FieldStatistics<ScalarSet>::add(const ScalarSet &set) {
+  using Traits = ScalarSetValueTraits<typename ScalarSet::value_type>;
+
+  numSets++;
+  double const weight = 1.0 / static_cast<double>(numSets);
+  std::array<double, cNumValues> values;
+  for (int i = 0; i < cNumValues; i++) {
+    values[i] = static_cast<double>(Traits::toScalar(set.data()[i]));
+  }
+
+  // Kept free of branches, so that it can be vectorized across the fields.
+  for (int i = 0; i < cNumValues; i++) {
+    double const delta = values[i] - means[i];
+    means[i] += delta * weight;
+    squares[i] += delta * (values[i] - means[i]);
+    lowest[i] = std::min(lowest[i], values[i]);
+    highest[i] = std::max(highest[i], values[i]);
+  }
+
+  for (int i = 0; i < cNumValues; i++) {
+    sketches[i].add(values[i]);
+  }
+}
+
+template <typename ScalarSet>
+void FieldStatistics<ScalarSet>::add(const ScalarSet *sets,
+                                     std::size_t count) {
+  for (std::size_t i = 0; i < count; i++) {
+    add(sets[i]);
+  }
+}
+
+template <typename ScalarSet>
+void FieldStatistics<ScalarSet>::merge(const FieldStatistics &other) {
+  if (other.numSets == 0) {
+    return;
+  }
+
+  // Chan et al.'s method of combining the means and squares of two streams.
+  auto const lhsCount = static_cast<double>(numSets);
+  auto const rhsCount = static_cast<double>(other.numSets);
+  double const total = lhsCount + rhsCount;
+  for (int i = 0; i < cNumValues; i++) {
+    double const delta = other.means[i] - means[i];
+    means[i] += delta * rhsCount / total;
+    squares[i] +=
+        other.squares[i] + delta * delta * lhsCount * rhsCount / total;
+    lowest[i] = std::min(lowest[i], other.lowest[i]);
+    highest[i] = std::max(highest[i], other.highest[i]);
+    sketches[i].merge(other.sketches[i]);
+  }
+  numSets += other.numSets;
+}
+
+template <typename ScalarSet>
+double FieldStatistics<ScalarSet>::quantile(enum_type field,
+                                            double q) const noexcept {
+  int const index = toIndex(field);
+  // The lowest and highest values are known exactly, and the sketch's
+  // estimate never lies outside them.
+  if (numSets == 0 || q <= 0) {
+    return numSets != 0 ? lowest[index]
+                        : std::numeric_limits<double>::quiet_NaN();
+  }
+  if (q >= 1) {
+    return highest[index];
+  }
+  return std::clamp(sketches[index].quantile(q), lowest[index],
+                    highest[index]);
+}
+
+} // namespace stec
+
+#endif // STEC_SCALAR_SET_STATISTICS_HPP
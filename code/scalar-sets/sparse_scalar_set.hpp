@@ -0,0 +1,649 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SPARSE_SCALAR_SET_HPP
+#define STEC_SPARSE_SCALAR_SET_HPP
+
+#include "bit_ops.hpp"
+#include "enum_traits.hpp"
+#include "scalar_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace stec {
+
+/// \brief A sparse form of the EnumeratedScalarSet, for large enums where most
+/// values are left at 0.
+/// \tparam T The underlying type of the template (ex int, float, etc.)
+/// \tparam EnumClass The enum type to use, must be zero-based and be in a solid
+/// incremental block.
+/// \tparam NumValues The number of values held in the template, by default the
+/// number of values in EnumClass, as found by EnumTraits.
+///
+/// Only the values that have been set are stored, packed together in enum
+/// order, along with a bitmap of which values those are. Values that aren't
+/// stored read as 0. The position of a stored value is found by counting the
+/// set bits below it, and operators only visit the stored values, so both the
+/// memory used and the cost of each operation scale with the number of values
+/// in use rather than the size of the enum.
+///
+/// The operators behave as they would for an EnumeratedScalarSet holding the
+/// same values, with a few exceptions to keep the set sparse:
+/// - Multiplying by a set only keeps values stored in both, as anything else
+///   would be 0.
+/// - Dividing by a set only divides the values stored in both, leaving values
+///   the divisor doesn't store as-is rather than dividing them by 0.
+/// - Adding or subtracting a single scalar value applies to every value, and so
+///   stores every value.
+template <typename T, class EnumClass,
+          int NumValues = EnumTraits<EnumClass>::count>
+class SparseEnumeratedScalarSet {
+  static_assert(std::is_arithmetic<T>::value,
+                "SparseEnumeratedScalarSet - Template parameter T must be of "
+                "arithmetic type.");
+
+  template <typename, class, int>
+  friend class SparseEnumeratedScalarSet;
+
+public:
+  /// The type of the stored values.
+  using value_type = T;
+
+  /// The enum type used to access the stored values.
+  using enum_type = EnumClass;
+
+  /// \brief Returns the number of values held in the template.
+  static constexpr int size() noexcept { return NumValues; }
+
+  /// \brief Default constructor, with no values stored.
+  SparseEnumeratedScalarSet() noexcept = default;
+
+  /// \brief Dense set constructor, storing only the non-zero values.
+  /// \param dense The set of values to start with.
+  template <typename Y, class Arithmetic>
+  explicit SparseEnumeratedScalarSet(
+      const EnumeratedScalarSet<Y, EnumClass, NumValues, Arithmetic> &dense);
+
+  /// \brief Converts back to the dense form, with unstored values as 0.
+  EnumeratedScalarSet<T, EnumClass, NumValues> toDense() const noexcept;
+
+  /// \brief Returns the number of values currently stored.
+  int count() const noexcept { return static_cast<int>(values.size()); }
+
+  /// \brief Returns whether the value denoted by the index is stored.
+  bool contains(const EnumClass) const noexcept;
+
+  /// \brief Stops storing the value denoted by the index, making it read as 0.
+  void erase(const EnumClass) noexcept;
+
+  /// \brief Stops storing any value that is currently 0.
+  void prune() noexcept;
+
+  /// \brief Calls the function with the index and a reference to each of the
+  /// stored values, in enum order.
+  template <typename Function>
+  void forEach(Function &&function);
+
+  /// \brief Calls the function with the index and each of the stored values,
+  /// in enum order.
+  template <typename Function>
+  void forEach(Function &&function) const;
+
+  /// \brief Returns a reference to the underlying value, denoted by the index,
+  /// storing it as 0 first if it isn't already stored.
+  /// \return A reference to the value.
+  T &operator[](const EnumClass);
+
+  /// \brief Returns the underlying value, denoted by the index, or 0 if it
+  /// isn't stored.
+  T operator[](const EnumClass) const noexcept;
+
+  template <typename Y>
+  bool
+  operator==(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const
+      noexcept;
+
+  template <typename Y>
+  bool
+  operator!=(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const
+      noexcept;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &
+  operator+=(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &
+  operator-=(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &
+  operator*=(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &
+  operator/=(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet
+  operator+(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet
+  operator-(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet
+  operator*(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet
+  operator/(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &operator+=(const Y);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &operator-=(const Y);
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &operator*=(const Y) noexcept;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet &operator/=(const Y) noexcept;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet operator+(const Y) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet operator-(const Y) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet operator*(const Y) const;
+
+  template <typename Y>
+  SparseEnumeratedScalarSet operator/(const Y) const;
+
+  /// \brief Clamps the minimum value of the internals to the given parameter.
+  /// If the minimum is above 0, every value becomes stored.
+  /// \param min The value that all values will be clamped to a minimum of.
+  void clampMin(T min);
+
+  /// \brief Clamps the maximum value of internals to the given parameter.
+  /// If the maximum is below 0, every value becomes stored.
+  /// \param max The value that all values will be clamped to a maximum of.
+  void clampMax(T max);
+
+private:
+  static constexpr int cNumWords = (NumValues + 63) / 64;
+
+  /// \brief Returns the position in the packed values of the given index,
+  /// which is the number of stored values before it.
+  int rank(int index) const noexcept;
+
+  /// \brief Stores every value that isn't already, as the given value.
+  void fill(T value);
+
+  /// \brief Rebuilds the stored values from the union of the values stored by
+  /// this and the other set.
+  /// \param rhs The other set.
+  /// \param function Called with each pair of values, whether each was stored,
+  /// and where to put the result. Returns whether the result is to be stored.
+  ///
+  /// The rebuild is done in place, from the highest index down, so that no
+  /// value is overwritten before it has been read.
+  template <typename Y, typename Function>
+  void merge(const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs,
+             Function &&function);
+
+  /// The bitmap of which values are stored, a bit per value.
+  std::array<std::uint64_t, cNumWords> present{};
+
+  /// The stored values, packed together in enum order.
+  std::vector<T> values;
+};
+
+/// \brief Adds the stored values of a sparse set to a dense set, only visiting
+/// the values stored, using the dense set's arithmetic.
+template <typename T, typename Y, class EnumClass, int NumValues,
+          class Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+operator+=(EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &lhs,
+           const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  rhs.forEach([&](EnumClass index, Y value) {
+    Arithmetic::add(&lhs[index], value, 1);
+  });
+  return lhs;
+}
+
+/// \brief Subtracts the stored values of a sparse set from a dense set, only
+/// visiting the values stored, using the dense set's arithmetic.
+template <typename T, typename Y, class EnumClass, int NumValues,
+          class Arithmetic>
+EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &
+operator-=(EnumeratedScalarSet<T, EnumClass, NumValues, Arithmetic> &lhs,
+           const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  rhs.forEach([&](EnumClass index, Y value) {
+    Arithmetic::subtract(&lhs[index], value, 1);
+  });
+  return lhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y, class Arithmetic>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::SparseEnumeratedScalarSet(
+    const EnumeratedScalarSet<Y, EnumClass, NumValues, Arithmetic> &dense) {
+  for (int i = 0; i < NumValues; i++) {
+    T const value = static_cast<T>(dense[static_cast<EnumClass>(i)]);
+    if (value != 0) {
+      present[i / 64] |= static_cast<std::uint64_t>(1) << (i % 64);
+      values.push_back(value);
+    }
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+EnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::toDense() const noexcept {
+  EnumeratedScalarSet<T, EnumClass, NumValues> retVal;
+  forEach([&](EnumClass index, T value) { retVal[index] = value; });
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues>
+bool SparseEnumeratedScalarSet<T, EnumClass, NumValues>::contains(
+    const EnumClass rhs) const noexcept {
+  int const index = static_cast<int>(rhs);
+  return (present[index / 64] >> (index % 64)) & 1;
+}
+
+template <typename T, class EnumClass, int NumValues>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::erase(
+    const EnumClass rhs) noexcept {
+  if (contains(rhs)) {
+    int const index = static_cast<int>(rhs);
+    values.erase(values.begin() + rank(index));
+    present[index / 64] &= ~(static_cast<std::uint64_t>(1) << (index % 64));
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::prune() noexcept {
+  int from = 0;
+  int to = 0;
+  detail::forEachSetBit(present.data(), cNumWords, [&](int index) {
+    if (values[from] == 0) {
+      present[index / 64] &= ~(static_cast<std::uint64_t>(1) << (index % 64));
+    } else {
+      values[to++] = values[from];
+    }
+    from++;
+  });
+  values.resize(to);
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Function>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::forEach(
+    Function &&function) {
+  T *value = values.data();
+  detail::forEachSetBit(present.data(), cNumWords, [&](int index) {
+    function(static_cast<EnumClass>(index), *value++);
+  });
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Function>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::forEach(
+    Function &&function) const {
+  const T *value = values.data();
+  detail::forEachSetBit(present.data(), cNumWords, [&](int index) {
+    function(static_cast<EnumClass>(index), *value++);
+  });
+}
+
+template <typename T, class EnumClass, int NumValues>
+T &SparseEnumeratedScalarSet<T, EnumClass, NumValues>::
+operator[](const EnumClass rhs) {
+  int const index = static_cast<int>(rhs);
+  int const position = rank(index);
+  if (!contains(rhs)) {
+    present[index / 64] |= static_cast<std::uint64_t>(1) << (index % 64);
+    values.insert(values.begin() + position, T{0});
+  }
+
+  return values[position];
+}
+
+template <typename T, class EnumClass, int NumValues>
+T SparseEnumeratedScalarSet<T, EnumClass, NumValues>::
+operator[](const EnumClass rhs) const noexcept {
+  return contains(rhs) ? values[rank(static_cast<int>(rhs))] : T{0};
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+bool SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator==(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const
+    noexcept {
+  // Walk the union, as a value stored in one but not the other can still be
+  // equal if it's stored as 0.
+  const T *lhsValue = values.data();
+  const Y *rhsValue = rhs.values.data();
+  for (int word = 0; word < cNumWords; word++) {
+    std::uint64_t bits = present[word] | rhs.present[word];
+    while (bits != 0) {
+      std::uint64_t const bit = bits & (~bits + 1);
+      T const lhsCurrent = (present[word] & bit) ? *lhsValue++ : T{0};
+      Y const rhsCurrent = (rhs.present[word] & bit) ? *rhsValue++ : Y{0};
+      if (lhsCurrent != rhsCurrent) {
+        return false;
+      }
+      bits &= bits - 1;
+    }
+  }
+
+  return true;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+bool SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator!=(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const
+    noexcept {
+  return !(*this == rhs);
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator+=(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  merge(rhs, [](T lhs, Y value, bool, bool, T &result) {
+    result = lhs;
+    result += value;
+    return true;
+  });
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator-=(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  merge(rhs, [](T lhs, Y value, bool, bool, T &result) {
+    result = lhs;
+    result -= value;
+    return true;
+  });
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator*=(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  merge(rhs, [](T lhs, Y value, bool inLhs, bool inRhs, T &result) {
+    result = lhs;
+    result *= value;
+    return inLhs && inRhs;
+  });
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator/=(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) {
+  merge(rhs, [](T lhs, Y value, bool inLhs, bool inRhs, T &result) {
+    result = lhs;
+    if (inRhs) {
+      result /= value;
+    }
+    return inLhs;
+  });
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator+(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) += rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator-(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) -= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+    SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator*(
+        const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) *= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator/(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) /= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator+=(const Y rhs) {
+  fill(0);
+  for (T &value : values) {
+    value += rhs;
+  }
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator-=(const Y rhs) {
+  fill(0);
+  for (T &value : values) {
+    value -= rhs;
+  }
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator*=(
+    const Y rhs) noexcept {
+  for (T &value : values) {
+    value *= rhs;
+  }
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues> &
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator/=(
+    const Y rhs) noexcept {
+  for (T &value : values) {
+    value /= rhs;
+  }
+
+  return *this;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator+(
+    const Y rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) += rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator-(
+    const Y rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) -= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+    SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator*(
+        const Y rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) *= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>
+SparseEnumeratedScalarSet<T, EnumClass, NumValues>::operator/(
+    const Y rhs) const {
+  return SparseEnumeratedScalarSet<T, EnumClass, NumValues>(*this) /= rhs;
+}
+
+template <typename T, class EnumClass, int NumValues>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::clampMin(T min) {
+  if (T{0} < min) {
+    fill(min);
+  }
+  for (T &value : values) {
+    value = std::max(value, min);
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::clampMax(T max) {
+  if (max < T{0}) {
+    fill(max);
+  }
+  for (T &value : values) {
+    value = std::min(value, max);
+  }
+}
+
+template <typename T, class EnumClass, int NumValues>
+int SparseEnumeratedScalarSet<T, EnumClass, NumValues>::rank(
+    int index) const noexcept {
+  int retVal = 0;
+  for (int word = 0; word < index / 64; word++) {
+    retVal += detail::popCount(present[word]);
+  }
+  if (index % 64 != 0) {
+    std::uint64_t const below =
+        (static_cast<std::uint64_t>(1) << (index % 64)) - 1;
+    retVal += detail::popCount(present[index / 64] & below);
+  }
+
+  return retVal;
+}
+
+template <typename T, class EnumClass, int NumValues>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::fill(T value) {
+  if (count() == NumValues) {
+    return;
+  }
+
+  SparseEnumeratedScalarSet<T, EnumClass, NumValues> all;
+  for (int word = 0; word < cNumWords; word++) {
+    all.present[word] = ~static_cast<std::uint64_t>(0);
+  }
+  if constexpr (NumValues % 64 != 0) {
+    all.present.back() =
+        (static_cast<std::uint64_t>(1) << (NumValues % 64)) - 1;
+  }
+
+  // The filled set has no values of its own, they're all just read as 0.
+  merge(all, [value](T lhs, T, bool inLhs, bool, T &result) {
+    result = inLhs ? lhs : value;
+    return true;
+  });
+}
+
+template <typename T, class EnumClass, int NumValues>
+template <typename Y, typename Function>
+void SparseEnumeratedScalarSet<T, EnumClass, NumValues>::merge(
+    const SparseEnumeratedScalarSet<Y, EnumClass, NumValues> &rhs,
+    Function &&function) {
+  int total = 0;
+  for (int word = 0; word < cNumWords; word++) {
+    total += detail::popCount(present[word] | rhs.present[word]);
+  }
+
+  int lhsPosition = count();
+  int rhsPosition = static_cast<int>(rhs.values.size());
+  int outPosition = total;
+  values.resize(std::max(total, count()));
+
+  for (int word = cNumWords - 1; word >= 0; word--) {
+    std::uint64_t const lhsBits = present[word];
+    std::uint64_t bits = lhsBits | rhs.present[word];
+    while (bits != 0) {
+      std::uint64_t const bit = static_cast<std::uint64_t>(1)
+                                << detail::highestSetBit(bits);
+      bool const inLhs = (lhsBits & bit) != 0;
+      bool const inRhs = (rhs.present[word] & bit) != 0;
+
+      // Values not stored read as 0, and aren't in the packed values.
+      T const lhsValue = inLhs ? values[--lhsPosition] : T{0};
+      Y const rhsValue =
+          (inRhs && rhsPosition > 0) ? rhs.values[--rhsPosition] : Y{0};
+
+      T result;
+      if (function(lhsValue, rhsValue, inLhs, inRhs, result)) {
+        values[--outPosition] = result;
+        present[word] |= bit;
+      } else {
+        present[word] &= ~bit;
+      }
+      bits &= ~bit;
+    }
+  }
+
+  // Anything dropped leaves a gap at the front.
+  values.erase(values.begin(), values.begin() + outPosition);
+}
+
+} // namespace stec
+
+#endif // STEC_SPARSE_SCALAR_SET_HPP
@@ -0,0 +1,161 @@
+/*
+    Copyright (C) 2018 George Cave - gcave@stablecoder.ca
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef STEC_SWAR_HPP
+#define STEC_SWAR_HPP
+
+#include <cstdint>
+#include <type_traits>
+
+namespace stec {
+
+namespace detail {
+
+// SIMD-within-a-register operations, treating a 64-bit word as lanes of the
+// integer type T. Lanes never carry or borrow into each other.
+
+/// \brief Returns the byte pattern repeated across every lane of type T.
+template <typename T>
+constexpr std::uint64_t swarRepeat(std::uint64_t laneValue) noexcept {
+  std::uint64_t retVal = 0;
+  for (unsigned i = 0; i < 64 / (sizeof(T) * 8); i++) {
+    retVal |= laneValue << (i * sizeof(T) * 8);
+  }
+  return retVal;
+}
+
+/// The highest bit of every lane.
+template <typename T>
+constexpr std::uint64_t cSwarHigh =
+    swarRepeat<T>(static_cast<std::uint64_t>(1) << (sizeof(T) * 8 - 1));
+
+/// Every bit of a lane, in the lowest lane.
+template <typename T>
+constexpr std::uint64_t cSwarLaneBits =
+    sizeof(T) == 8 ? ~static_cast<std::uint64_t>(0)
+                   : (static_cast<std::uint64_t>(1) << (sizeof(T) * 8)) - 1;
+
+/// \brief Returns the value in every lane.
+template <typename T>
+constexpr std::uint64_t swarBroadcast(const T value) noexcept {
+  return swarRepeat<T>(
+      static_cast<std::uint64_t>(
+          static_cast<typename std::make_unsigned<T>::type>(value)));
+}
+
+/// \brief Turns the highest bit of each lane into the whole lane.
+template <typename T>
+constexpr std::uint64_t swarSpread(const std::uint64_t highBits) noexcept {
+  return (highBits >> (sizeof(T) * 8 - 1)) * cSwarLaneBits<T>;
+}
+
+/// \brief Adds each lane, wrapping around on overflow.
+template <typename T>
+constexpr std::uint64_t swarAdd(const std::uint64_t lhs,
+                                const std::uint64_t rhs) noexcept {
+  // The top bit of each lane is left out of the add, so can't carry into the
+  // next lane, and is then worked out on its own.
+  return ((lhs & ~cSwarHigh<T>) + (rhs & ~cSwarHigh<T>)) ^
+         ((lhs ^ rhs) & cSwarHigh<T>);
+}
+
+/// \brief Subtracts each lane, wrapping around on overflow.
+template <typename T>
+constexpr std::uint64_t swarSubtract(const std::uint64_t lhs,
+                                     const std::uint64_t rhs) noexcept {
+  // The top bit of each lane of lhs is set, so can't borrow from the next
+  // lane, and is then worked out on its own.
+  return ((lhs | cSwarHigh<T>) - (rhs & ~cSwarHigh<T>)) ^
+         ((lhs ^ ~rhs) & cSwarHigh<T>);
+}
+
+/// \brief Returns the saturated value for each lane that overflowed, the
+/// maximum for lanes where lhs is positive, the minimum where negative.
+template <typename T>
+constexpr std::uint64_t swarSignedLimit(const std::uint64_t lhs) noexcept {
+  return ~cSwarHigh<T> + ((lhs & cSwarHigh<T>) >> (sizeof(T) * 8 - 1));
+}
+
+/// \brief Adds each lane, clamping to the range of T on overflow.
+template <typename T>
+constexpr std::uint64_t swarAddSaturate(const std::uint64_t lhs,
+                                        const std::uint64_t rhs) noexcept {
+  std::uint64_t const sum = swarAdd<T>(lhs, rhs);
+  if constexpr (std::is_signed<T>::value) {
+    // Overflowed where both had the same sign, which the sum doesn't.
+    std::uint64_t const overflow =
+        swarSpread<T>(~(lhs ^ rhs) & (lhs ^ sum) & cSwarHigh<T>);
+    return (sum & ~overflow) | (swarSignedLimit<T>(lhs) & overflow);
+  } else {
+    std::uint64_t const carry =
+        swarSpread<T>(((lhs & rhs) | ((lhs | rhs) & ~sum)) & cSwarHigh<T>);
+    return sum | carry;
+  }
+}
+
+/// \brief Subtracts each lane, clamping to the range of T on overflow.
+template <typename T>
+constexpr std::uint64_t swarSubtractSaturate(const std::uint64_t lhs,
+                                             const std::uint64_t rhs) noexcept {
+  std::uint64_t const difference = swarSubtract<T>(lhs, rhs);
+  if constexpr (std::is_signed<T>::value) {
+    // Overflowed where the signs differed, and the result's differs from lhs.
+    std::uint64_t const overflow =
+        swarSpread<T>((lhs ^ rhs) & (lhs ^ difference) & cSwarHigh<T>);
+    return (difference & ~overflow) | (swarSignedLimit<T>(lhs) & overflow);
+  } else {
+    std::uint64_t const borrow = swarSpread<T>(
+        ((~lhs & rhs) | (~(lhs ^ rhs) & difference)) & cSwarHigh<T>);
+    return difference & ~borrow;
+  }
+}
+
+/// \brief Returns every bit set in the lanes where lhs is less than rhs.
+template <typename T>
+constexpr std::uint64_t swarLessThan(std::uint64_t lhs,
+                                     std::uint64_t rhs) noexcept {
+  if constexpr (std::is_signed<T>::value) {
+    // Flipping the sign bits orders signed values as unsigned ones.
+    lhs ^= cSwarHigh<T>;
+    rhs ^= cSwarHigh<T>;
+  }
+  // The borrow out of the top of each lane of lhs - rhs.
+  std::uint64_t const difference = swarSubtract<T>(lhs, rhs);
+  return swarSpread<T>(((~lhs & rhs) | (~(lhs ^ rhs) & difference)) &
+                       cSwarHigh<T>);
+}
+
+/// \brief Returns the larger of each lane.
+template <typename T>
+constexpr std::uint64_t swarMax(const std::uint64_t lhs,
+                                const std::uint64_t rhs) noexcept {
+  std::uint64_t const less = swarLessThan<T>(lhs, rhs);
+  return (lhs & ~less) | (rhs & less);
+}
+
+/// \brief Returns the smaller of each lane.
+template <typename T>
+constexpr std::uint64_t swarMin(const std::uint64_t lhs,
+                                const std::uint64_t rhs) noexcept {
+  std::uint64_t const less = swarLessThan<T>(lhs, rhs);
+  return (lhs & less) | (rhs & ~less);
+}
+
+} // namespace detail
+
+} // namespace stec
+
+#endif // STEC_SWAR_HPP